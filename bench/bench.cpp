@@ -0,0 +1,489 @@
+// Microbenchmarks of the genetic operators and the MIDI encoder.
+//
+//   OMeGA-bench [--json <file|->] [--filter <text>] [--min-time <ms>] [--quick] [--log]
+//
+// Every benchmark runs over a sweep of population sizes and genome lengths and reports the median
+// ns/op of several samples, heap allocations and bytes per op, and ops/s (generations/s for the
+// evolution benchmarks). --json writes the same results in a form that can be diffed between builds.
+// Logging is switched off unless --log is given, so the numbers show the operators themselves.
+
+#include "algorithm/evolution.h"
+#include "algorithm/genetic.h"
+#include "algorithm/metrics.h"
+#include "algorithm/note_events.h"
+#include "algorithm/static_evolution.h"
+#include "midi.h"
+#include "scale.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#ifndef OMEGA_VERSION
+#define OMEGA_VERSION "unknown"
+#endif
+
+using namespace GeneticAlgorithm;
+
+// allocation counting: every global operator new of the process goes through here
+
+static std::atomic<uint64_t> g_allocations{0};
+static std::atomic<uint64_t> g_allocatedBytes{0};
+
+static void* countedAlloc(size_t size, size_t alignment)
+{
+	g_allocations.fetch_add(1, std::memory_order_relaxed);
+	g_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+	size = size == 0 ? 1 : size;
+	void* p = nullptr;
+	if (alignment <= alignof(std::max_align_t))
+		p = std::malloc(size);
+	else
+	{
+#if defined(_MSC_VER)
+		p = _aligned_malloc(size, alignment);
+#else
+		if (posix_memalign(&p, alignment, size) != 0)
+			p = nullptr;
+#endif
+	}
+
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+static void countedFree(void* p, size_t alignment) noexcept
+{
+#if defined(_MSC_VER)
+	if (alignment > alignof(std::max_align_t))
+	{
+		_aligned_free(p);
+		return;
+	}
+#else
+	(void)alignment;
+#endif
+	std::free(p);
+}
+
+void* operator new(size_t size) { return countedAlloc(size, 0); }
+void* operator new[](size_t size) { return countedAlloc(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment) { return countedAlloc(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return countedAlloc(size, static_cast<size_t>(alignment)); }
+void operator delete(void* p) noexcept { countedFree(p, 0); }
+void operator delete[](void* p) noexcept { countedFree(p, 0); }
+void operator delete(void* p, size_t) noexcept { countedFree(p, 0); }
+void operator delete[](void* p, size_t) noexcept { countedFree(p, 0); }
+void operator delete(void* p, std::align_val_t alignment) noexcept { countedFree(p, static_cast<size_t>(alignment)); }
+void operator delete[](void* p, std::align_val_t alignment) noexcept { countedFree(p, static_cast<size_t>(alignment)); }
+void operator delete(void* p, size_t, std::align_val_t alignment) noexcept { countedFree(p, static_cast<size_t>(alignment)); }
+void operator delete[](void* p, size_t, std::align_val_t alignment) noexcept { countedFree(p, static_cast<size_t>(alignment)); }
+
+// keeps the compiler from dropping a result that is never read
+static const void* volatile g_sink;
+
+template<typename T>
+static void keep(const T& value)
+{
+	g_sink = &value;
+	std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+struct BenchOptions
+{
+	std::string json;
+	std::string filter;
+	double minTime = 0.05; // seconds per sample
+	size_t samples = 5;
+	bool quick	   = false;
+	bool log	   = false;
+};
+
+struct BenchResult
+{
+	std::string name;
+	size_t population;
+	size_t genomeLength;
+	uint64_t iterations; // per sample
+	double nsPerOp;		 // median of the samples
+	double minNsPerOp;
+	double allocsPerOp;
+	double bytesPerOp;
+	double opsPerSec;
+};
+
+class Bench
+{
+public:
+	Bench(const BenchOptions& options, std::FILE* report) : m_options(options), m_report(report) {}
+
+	const std::vector<BenchResult>& results() const { return m_results; };
+
+	bool enabled(const std::string& name) const { return m_options.filter.empty() || name.find(m_options.filter) != std::string::npos; };
+
+	// Calls op(), which performs one operation, in batches sized to last at least minTime each.
+	template<typename Op>
+	void run(const std::string& name, size_t population, size_t genomeLength, Op&& op)
+	{
+		if (!enabled(name))
+			return;
+
+		using clock = std::chrono::steady_clock;
+		auto timeBatch = [&](uint64_t iterations) {
+			const auto start = clock::now();
+			for (uint64_t i = 0; i < iterations; ++i)
+				op();
+			return std::chrono::duration<double>(clock::now() - start).count();
+		};
+
+		// warm up caches and buffers, then grow the batch until it is long enough to time
+		timeBatch(1);
+		uint64_t iterations = 1;
+		for (double elapsed = timeBatch(iterations); elapsed < m_options.minTime && iterations < (uint64_t{1} << 40);)
+		{
+			const double scale = elapsed > 0 ? std::min(10.0, 1.2 * m_options.minTime / elapsed) : 10.0;
+			iterations		   = std::max<uint64_t>(iterations + 1, static_cast<uint64_t>(static_cast<double>(iterations) * scale));
+			elapsed			   = timeBatch(iterations);
+		}
+
+		std::vector<double> samples;
+		const uint64_t allocations = g_allocations.load(std::memory_order_relaxed);
+		const uint64_t bytes	   = g_allocatedBytes.load(std::memory_order_relaxed);
+		for (size_t s = 0; s < m_options.samples; ++s)
+			samples.push_back(timeBatch(iterations) * 1e9 / static_cast<double>(iterations));
+		const double ops = static_cast<double>(iterations * m_options.samples);
+
+		std::sort(samples.begin(), samples.end());
+		BenchResult result;
+		result.name			= name;
+		result.population	= population;
+		result.genomeLength = genomeLength;
+		result.iterations	= iterations;
+		result.nsPerOp		= samples[samples.size() / 2];
+		result.minNsPerOp	= samples.front();
+		result.allocsPerOp	= static_cast<double>(g_allocations.load(std::memory_order_relaxed) - allocations) / ops;
+		result.bytesPerOp	= static_cast<double>(g_allocatedBytes.load(std::memory_order_relaxed) - bytes) / ops;
+		result.opsPerSec	= 1e9 / result.nsPerOp;
+
+		std::fprintf(m_report, "%-34s %8zu %8zu %14.1f %12.2f %12.1f %14.1f\n", name.c_str(), population, genomeLength, result.nsPerOp,
+					 result.allocsPerOp, result.bytesPerOp, result.opsPerSec);
+		std::fflush(m_report);
+		m_results.push_back(result);
+	}
+
+private:
+	BenchOptions m_options;
+	std::FILE* m_report; // human-readable table
+	std::vector<BenchResult> m_results;
+};
+
+static void writeJson(std::FILE* out, const BenchOptions& options, const std::vector<BenchResult>& results)
+{
+#if defined(NDEBUG)
+	const char* buildType = "release";
+#else
+	const char* buildType = "debug";
+#endif
+#if defined(__clang__)
+	const char* compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+	const char* compiler = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+	const char* compiler = "msvc";
+#else
+	const char* compiler = "unknown";
+#endif
+
+	std::fprintf(out, "{\n");
+	std::fprintf(out, "  \"version\": \"%s\",\n", OMEGA_VERSION);
+	std::fprintf(out, "  \"build\": \"%s\",\n", buildType);
+	std::fprintf(out, "  \"compiler\": \"%s\",\n", compiler);
+	std::fprintf(out, "  \"min_time_ms\": %.0f,\n", options.minTime * 1000);
+	std::fprintf(out, "  \"samples\": %zu,\n", options.samples);
+	std::fprintf(out, "  \"logging\": %s,\n", options.log ? "true" : "false");
+	std::fprintf(out, "  \"benchmarks\": [\n");
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const auto& r = results[i];
+		std::fprintf(out,
+					 "    {\"name\": \"%s\", \"population\": %zu, \"genome_length\": %zu, \"iterations\": %llu, \"ns_per_op\": %.2f, "
+					 "\"min_ns_per_op\": %.2f, \"allocs_per_op\": %.3f, \"bytes_per_op\": %.1f, \"ops_per_sec\": %.1f}%s\n",
+					 r.name.c_str(), r.population, r.genomeLength, static_cast<unsigned long long>(r.iterations), r.nsPerOp, r.minNsPerOp, r.allocsPerOp,
+					 r.bytesPerOp, r.opsPerSec, i + 1 < results.size() ? "," : "");
+	}
+	std::fprintf(out, "  ]\n}\n");
+}
+
+// cheap stand-in for a real fitness function, so the evolution benchmarks measure the engine
+static int countOnes(const Genome& genome)
+{
+	int ones = 0;
+	for (size_t w = 0; w < genome.wordCount(); ++w)
+	{
+		for (Genome::word_t word = genome.word(w); word; word &= word - 1)
+			++ones;
+	}
+	return ones;
+}
+
+static void genomeBenchmarks(Bench& bench, const std::vector<size_t>& lengths)
+{
+	Rng rng(1);
+	const Scale scale(ScaleType::MAJOR, "C");
+	const MidiEncoder encoder(scale, 130);
+
+	for (const size_t length : lengths)
+	{
+		bench.run("genome/generate", 1, length, [&] { keep(Genetic::generateGenome(length, rng)); });
+
+		Genome first  = Genetic::generateGenome(length, rng);
+		Genome second = Genetic::generateGenome(length, rng);
+		bench.run("genome/crossover_copy", 1, length, [&] { keep(Genetic::singlePointCrossover(first, second, rng)); });
+
+		Genome offspringA(length);
+		Genome offspringB(length);
+		bench.run("genome/crossover_into", 1, length, [&] {
+			Genetic::singlePointCrossover(first, second, offspringA, offspringB, rng);
+			keep(offspringA);
+		});
+
+		for (const auto& [name, type] : {std::make_pair("genome/crossover_two_point", CrossoverType::TWO_POINT),
+										 std::make_pair("genome/crossover_uniform", CrossoverType::UNIFORM),
+										 std::make_pair("genome/crossover_note_aligned", CrossoverType::NOTE_ALIGNED),
+										 std::make_pair("genome/crossover_bar_aligned", CrossoverType::BAR_ALIGNED)})
+		{
+			bench.run(name, 1, length, [&, type = type] {
+				Genetic::crossover(type, first, second, offspringA, offspringB, rng);
+				keep(offspringA);
+			});
+		}
+
+		bench.run("genome/mutation", 1, length, [&] {
+			Genetic::mutation(first, 1, 0.5f, rng);
+			keep(first);
+		});
+
+		// about one flip per melody of the default length
+		bench.run("genome/flip_mutation", 1, length, [&] {
+			keep(Genetic::flipMutation(offspringA, 1.0 / GENOME_LENGTH, rng));
+			keep(offspringA);
+		});
+
+		NoteEvents events;
+		bench.run("midi/decode_notes", 1, length, [&] {
+			NoteEvents::decode(first, events);
+			keep(events);
+		});
+
+		MidiEncoder::Bytes bytes;
+		bench.run("midi/write_genome_bytes", 1, length, [&] {
+			bytes.clear();
+			encoder.writeGenomeToMidiBytes(first, bytes);
+			keep(bytes);
+		});
+
+		bench.run("midi/encode_genome", 1, length, [&] {
+			encoder.encodeGenomeToMidi(first, bytes);
+			keep(bytes);
+		});
+	}
+}
+
+static void populationBenchmarks(Bench& bench, const std::vector<size_t>& populations, const std::vector<size_t>& lengths)
+{
+	Rng rng(2);
+	for (const size_t population : populations)
+	{
+		for (const size_t length : lengths)
+		{
+			const Population genomes = Genetic::generatePopulation(population, length, rng);
+			std::vector<int> weights(population);
+			for (size_t i = 0; i < population; ++i)
+				weights[i] = countOnes(genomes[i]);
+
+			WeightedPopulation weighted;
+			Genetic::weightPopulation(weights, weighted);
+
+			bench.run("population/selection_pair", population, length, [&] { keep(Genetic::selectionPair(genomes, weighted, rng)); });
+			bench.run("population/selection_indices", population, length, [&] { keep(Genetic::selectionPairIndices(weighted, rng)); });
+			bench.run("population/weight", population, length, [&] {
+				Genetic::weightPopulation(weights, weighted);
+				keep(weighted);
+			});
+			bench.run("population/sort", population, length, [&] { keep(Genetic::sortPopulation(genomes, weighted)); });
+			std::vector<GenomeView> sorted;
+			bench.run("population/sort_views", population, length, [&] {
+				Genetic::sortPopulation(genomes, weighted, sorted);
+				keep(sorted);
+			});
+
+			ParentPairs pairs(population / 2);
+			for (auto& [first, second] : pairs)
+				std::tie(first, second) = Genetic::selectionPairIndices(weighted, rng);
+			Population offspring(2 * pairs.size(), Genome(length));
+			bench.run("population/crossover_batch", population, length, [&] {
+				Genetic::crossover(CrossoverType::NOTE_ALIGNED, genomes, pairs, offspring, rng);
+				keep(offspring);
+			});
+			bench.run("population/flip_mutation", population, length, [&] {
+				keep(Genetic::flipMutation(offspring, 1.0 / GENOME_LENGTH, rng));
+				keep(offspring);
+			});
+
+			// one evaluate + breed per op, so ops/s is generations/s
+			EvolutionConfig config;
+			config.populationSize = population;
+			config.genomeLength	  = length;
+			config.seed			  = 3;
+			config.elites		  = std::min<size_t>(2, population);
+			for (const auto& [name, strategy] : {std::make_pair("evolution/generation_prefix_sum", SelectionStrategy::PREFIX_SUM),
+												 std::make_pair("evolution/generation_alias", SelectionStrategy::ALIAS),
+												 std::make_pair("evolution/generation_tournament", SelectionStrategy::TOURNAMENT)})
+			{
+				if (!bench.enabled(name))
+					continue;
+
+				config.selection = strategy;
+				Evolution evolution(config);
+				evolution.initPopulation();
+				const FitnessFunc fitness = countOnes;
+				bench.run(name, population, length, [&] {
+					evolution.evaluate(fitness);
+					evolution.breed();
+				});
+			}
+
+			// the same scorer evaluated in full and incrementally from the parents' note counts
+			const MelodyScorer scorer(Scale(ScaleType::MAJOR, "C"));
+			config.selection = SelectionStrategy::PREFIX_SUM;
+			if (bench.enabled("evolution/generation_melody"))
+			{
+				Evolution evolution(config);
+				evolution.initPopulation();
+				const FitnessFunc fitness = scorer.genomeFitnessFunc();
+				bench.run("evolution/generation_melody", population, length, [&] {
+					evolution.evaluate(fitness);
+					evolution.breed();
+				});
+			}
+			if (bench.enabled("evolution/generation_incremental"))
+			{
+				Evolution evolution(config);
+				evolution.initPopulation();
+				bench.run("evolution/generation_incremental", population, length, [&] {
+					evolution.evaluate(scorer);
+					evolution.breed();
+				});
+			}
+		}
+	}
+}
+
+// compile-time engine at the dynamic engine's defaults, for comparison with evolution/generation_prefix_sum
+template<size_t Bits, size_t PopulationSize>
+static void staticEvolutionBenchmark(Bench& bench)
+{
+	StaticEvolutionConfig config;
+	config.seed	  = 3;
+	config.elites = std::min<size_t>(2, PopulationSize);
+	auto evolution = makeStaticEvolution<Bits, PopulationSize>(
+		[](const FixedGenome<Bits>& genome) {
+			int ones = 0;
+			for (size_t w = 0; w < FixedGenome<Bits>::WORDS; ++w)
+			{
+				for (Genome::word_t word = genome.word(w); word; word &= word - 1)
+					++ones;
+			}
+			return ones;
+		},
+		config);
+	evolution.initPopulation();
+	bench.run("static/generation", PopulationSize, Bits, [&] {
+		evolution.evaluate();
+		evolution.breed();
+	});
+}
+
+static void staticBenchmarks(Bench& bench, bool quick)
+{
+	if (!bench.enabled("static/generation"))
+		return;
+
+	staticEvolutionBenchmark<128, 6>(bench);
+	staticEvolutionBenchmark<128, 64>(bench);
+	staticEvolutionBenchmark<1024, 64>(bench);
+	if (!quick)
+		staticEvolutionBenchmark<128, 1024>(bench);
+}
+
+static bool parseArguments(int argc, char** argv, BenchOptions& options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		const bool hasValue	  = i + 1 < argc;
+		if (arg == "--json" && hasValue)
+			options.json = argv[++i];
+		else if (arg == "--filter" && hasValue)
+			options.filter = argv[++i];
+		else if (arg == "--min-time" && hasValue)
+			options.minTime = std::atof(argv[++i]) / 1000.0;
+		else if (arg == "--samples" && hasValue)
+			options.samples = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+		else if (arg == "--quick")
+			options.quick = true;
+		else if (arg == "--log")
+			options.log = true;
+		else
+		{
+			std::fprintf(stderr, "usage: %s [--json <file|->] [--filter <text>] [--min-time <ms>] [--samples <n>] [--quick] [--log]\n", argv[0]);
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	BenchOptions options;
+	if (!parseArguments(argc, argv, options))
+		return 1;
+
+	if (!options.log)
+		spdlog::set_level(spdlog::level::off);
+
+	const std::vector<size_t> lengths	  = options.quick ? std::vector<size_t>{128, 1024} : std::vector<size_t>{128, 1024, 8192};
+	const std::vector<size_t> populations = options.quick ? std::vector<size_t>{6, 64} : std::vector<size_t>{6, 64, 1024};
+
+	// the table goes to stderr when the JSON takes stdout
+	std::FILE* report = options.json == "-" ? stderr : stdout;
+	std::fprintf(report, "%-34s %8s %8s %14s %12s %12s %14s\n", "benchmark", "pop", "length", "ns/op", "allocs/op", "bytes/op", "ops/s");
+
+	Bench bench(options, report);
+	genomeBenchmarks(bench, lengths);
+	populationBenchmarks(bench, populations, lengths);
+	staticBenchmarks(bench, options.quick);
+
+	if (!options.json.empty())
+	{
+		std::FILE* out = options.json == "-" ? stdout : std::fopen(options.json.c_str(), "w");
+		if (!out)
+		{
+			std::fprintf(stderr, "cannot write %s\n", options.json.c_str());
+			return 1;
+		}
+		writeJson(out, options, bench.results());
+		if (out != stdout)
+			std::fclose(out);
+	}
+	return 0;
+}
@@ -0,0 +1,56 @@
+#ifndef OMEGA_CHECKPOINT
+#define OMEGA_CHECKPOINT
+
+#include "algorithm/evolution.h"
+#include "utility/mapped_file.h"
+#include <string>
+
+namespace GeneticAlgorithm
+{
+	// Binary snapshot of an Evolution: its config, generation, generator state, the packed genomes, their weights
+	// when the population was evaluated and the entries of the fitness cache.
+	// The file is a fixed header followed by 64-byte aligned sections of raw words in native byte order, so a
+	// checkpoint is memory-mapped and read in place; a checksum over everything after it catches torn or damaged files.
+	// Resume with: Checkpoint checkpoint(path); Evolution evolution(checkpoint.config()); evolution.resume(checkpoint);
+	class Checkpoint
+	{
+	public:
+		// Writes to a temporary file next to path, flushes it to disk and renames it over path,
+		// so path always holds a complete checkpoint, the previous one or the new one.
+		static void save(const Evolution& evolution, const std::string& path);
+
+		// maps the file and validates its header and size, and its checksum when verify is set
+		explicit Checkpoint(const std::string& path, bool verify = true);
+
+		const EvolutionConfig& config() const { return m_config; };
+		uint64_t generation() const { return m_generation; };
+		const Rng::state_t& rngState() const { return m_rngState; };
+
+		size_t populationSize() const { return m_config.populationSize; };
+		size_t genomeLength() const { return m_config.genomeLength; };
+		size_t wordsPerGenome() const { return Genome::wordsForBits(m_config.genomeLength); };
+		// genome idx, viewed straight in the mapping
+		GenomeView genome(size_t idx) const { return GenomeView(m_genomes + idx * wordsPerGenome(), genomeLength()); };
+		// weight of every genome, nullptr when the population was saved before it was evaluated
+		const int* weights() const { return m_weights; };
+
+		// fitness cache entries, laid out like FitnessCache::keyData(), hashData() and weightData()
+		size_t cacheEntries() const { return m_cacheEntries; };
+		const Genome::word_t* cacheKeys() const { return m_cacheKeys; };
+		const uint64_t* cacheHashes() const { return m_cacheHashes; };
+		const int* cacheWeights() const { return m_cacheWeights; };
+
+	private:
+		utility::MappedFile m_file;
+		EvolutionConfig m_config;
+		uint64_t m_generation{0};
+		Rng::state_t m_rngState{};
+		const Genome::word_t* m_genomes{nullptr};
+		const int* m_weights{nullptr};
+		size_t m_cacheEntries{0};
+		const Genome::word_t* m_cacheKeys{nullptr};
+		const uint64_t* m_cacheHashes{nullptr};
+		const int* m_cacheWeights{nullptr};
+	};
+}
+#endif // !OMEGA_CHECKPOINT
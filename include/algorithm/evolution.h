@@ -0,0 +1,154 @@
+#ifndef OMEGA_EVOLUTION
+#define OMEGA_EVOLUTION
+
+#include "algorithm/genetic.h"
+#include "algorithm/fitness_cache.h"
+#include "algorithm/selection.h"
+#include "algorithm/telemetry.h"
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace GeneticAlgorithm
+{
+	class Checkpoint;
+
+	struct EvolutionConfig
+	{
+		size_t populationSize = GENOMES_IN_POPULATION;
+		size_t genomeLength	  = GENOME_LENGTH;
+		// unset draws a seed from Random::threadRng()
+		std::optional<uint64_t> seed{};
+		// best genomes copied unchanged into the next generation
+		size_t elites				= 2;
+		SelectionStrategy selection = SelectionStrategy::ALIAS;
+		size_t tournamentSize		= 2;
+		CrossoverType crossover		= CrossoverType::SINGLE_POINT;
+		size_t mutationCount		= 1;
+		float mutationProbability	= 0.5f;
+		// above 0 every offspring bit flips with this probability (Genetic::flipMutation)
+		// instead of the mutationCount draws above
+		double mutationRate = 0.0;
+		// genomes whose weight is remembered between evaluations, 0 disables the fitness cache.
+		// Only enable it for fitness functions that give the same genome the same weight.
+		size_t fitnessCacheCapacity = 0;
+	};
+
+	// One independent evolution: owns its config, population, weights and generator.
+	// Distinct instances share no state and can run on different threads at the same time;
+	// a single instance is not meant to be used from several threads at once.
+	class Evolution
+	{
+	public:
+		explicit Evolution(const EvolutionConfig& config = {});
+
+		const EvolutionConfig& config() const { return m_config; };
+		const Population& population() const { return m_population; };
+		Population& population() { return m_population; };
+		const WeightedPopulation& weightedPopulation() const { return m_weightedPopulation; };
+		Rng& rng() { return m_rng; };
+		const Rng& rng() const { return m_rng; };
+
+		uint64_t generation() const { return m_generation; };
+
+		// Times the stages of every generation and publishes its stats after each evaluation; nullptr (the default)
+		// turns it off, leaving a single branch per stage. The telemetry must outlive its use by the evolution.
+		void setTelemetry(Telemetry* telemetry) { m_telemetry = telemetry; };
+		Telemetry* telemetry() const { return m_telemetry; };
+
+		// run() writes a checkpoint to path after every interval-th evaluated generation; 0 turns it off
+		void setCheckpoint(std::string path, uint32_t interval);
+		// Continues from a checkpoint whose population size and genome length match the config: restores the population,
+		// generator, generation counter and fitness cache. A population saved evaluated is not evaluated again by run().
+		void resume(const Checkpoint& checkpoint);
+
+		// fills the population with random genomes of the configured length and preallocates the offspring buffer
+		void initPopulation();
+
+		void evaluate(const FitnessFunc& fitnessFunc);
+		void evaluate(const BatchFitnessFunc& fitnessFunc, utility::ThreadPool& pool);
+		// hands the whole population to fitnessFunc in one call on the calling thread
+		void evaluate(const BatchFitnessFunc& fitnessFunc);
+		// Keeps the summary of every genome and scores an offspring by updating the summary of the parent it
+		// differs from the least over the notes that differ. Genomes are scored in full when there are no summaries
+		// from the same fitness object for the bred population: the first generation, after initPopulation(),
+		// resume() or another evaluate(), and for parents changed after their evaluation. The fitness cache is not used.
+		// The hashing and diffing of every offspring pays off with long genomes; at 128 bits a plain evaluate() is faster.
+		void evaluate(const IncrementalFitness& fitness);
+		void evaluate(const IncrementalFitness& fitness, utility::ThreadPool& pool);
+
+		// Replaces the evaluated population with the next generation: elites are copied over, the rest are
+		// crossed over and mutated straight into the spare buffer, then the buffers are swapped.
+		void breed();
+
+		// Evaluates and breeds until a genome reaches fitnessLimit or generationLimit generations were evaluated.
+		// The returned population is the last evaluated one, see best() and weightedPopulation().
+		// Apart from the first generation no heap allocation is made by the loop itself.
+		const Population& run(const FitnessFunc& fitnessFunc, int fitnessLimit, uint32_t generationLimit = 100);
+		const Population& run(const BatchFitnessFunc& fitnessFunc, utility::ThreadPool& pool, int fitnessLimit, uint32_t generationLimit = 100);
+		const Population& run(const BatchFitnessFunc& fitnessFunc, int fitnessLimit, uint32_t generationLimit = 100);
+		const Population& run(const IncrementalFitness& fitness, int fitnessLimit, uint32_t generationLimit = 100);
+		const Population& run(const IncrementalFitness& fitness, utility::ThreadPool& pool, int fitnessLimit, uint32_t generationLimit = 100);
+
+		// population ordered by the last evaluation, best first unless reversed is false
+		Population sortedPopulation(bool reversed = true) const;
+		// the same order as views into population(), valid until the next breed()
+		void sortedPopulation(std::vector<GenomeView>& sorted, bool reversed = true) const;
+		std::tuple<GenomeView, GenomeView> selectionPair();
+
+		int populationFitness() const { return Genetic::populationFitness(m_weightedPopulation); };
+		int maxWeight() const;
+		// best genome of the last evaluation
+		const Genome& best() const;
+
+		// nullptr when the cache is disabled
+		const FitnessCache* fitnessCache() const { return m_cache.get(); };
+		FitnessCache* fitnessCache() { return m_cache.get(); };
+
+	private:
+		template<typename EvaluateFunc>
+		const Population& runLoop(EvaluateFunc&& evaluateFunc, int fitnessLimit, uint32_t generationLimit);
+		void evaluateCached(const FitnessFunc& fitnessFunc);
+		// pool == nullptr scores the misses on the calling thread
+		void evaluateCached(const BatchFitnessFunc& fitnessFunc, utility::ThreadPool* pool);
+		// pool == nullptr scores on the calling thread
+		void evaluateIncremental(const IncrementalFitness& fitness, utility::ThreadPool* pool);
+		// common end of all evaluate() overloads
+		void finishEvaluation();
+		void saveCheckpoint();
+
+		EvolutionConfig m_config;
+		Rng m_rng;
+		Population m_population;
+		Population m_nextPopulation;
+		Genome m_spare; // second offspring of the last pair when the slots left are odd
+		WeightedPopulation m_weightedPopulation;
+		std::vector<int> m_weights;
+		Selector m_selector;
+		ParentPairs m_parents;
+		uint64_t m_generation{0};
+		Telemetry* m_telemetry{nullptr};
+		size_t m_evaluations{0}; // fitness function calls of the last evaluation
+		std::string m_checkpointPath;
+		uint32_t m_checkpointInterval{0};
+		bool m_resumedEvaluated{false}; // population restored with its weights and not bred since
+
+		std::unique_ptr<FitnessCache> m_cache;
+		std::vector<uint64_t> m_hashes;
+		std::vector<uint32_t> m_misses;		   // population indices not found in the cache
+		std::vector<uint32_t> m_missSource;	   // for every miss, its slot in m_missGenomes
+		Population m_missGenomes;			   // distinct missed genomes, only the first m_missCount are used
+		std::vector<int> m_missWeights;
+		size_t m_missCount{0};
+
+		std::vector<std::pair<uint32_t, uint32_t>> m_lineage; // parents of every genome in the previous population
+		std::vector<uint64_t> m_states;						  // IncrementalFitness summaries, m_stateStride words per genome
+		std::vector<uint64_t> m_stateHashes;				  // hash of every genome when its summary was written
+		std::vector<uint64_t> m_parentStates;				  // summaries of the previous population, kept in m_nextPopulation
+		std::vector<uint64_t> m_parentHashes;
+		std::vector<uint8_t> m_parentValid;					  // parent still holds the genome its summary was written for
+		size_t m_stateStride{0};
+		const IncrementalFitness* m_stateFitness{nullptr}; // wrote m_states for m_population, nullptr when they are stale
+	};
+}
+#endif // !OMEGA_EVOLUTION
@@ -0,0 +1,70 @@
+#ifndef OMEGA_FITNESS_CACHE
+#define OMEGA_FITNESS_CACHE
+
+#include "algorithm/genome.h"
+#include <optional>
+#include <vector>
+
+namespace GeneticAlgorithm
+{
+	// Bounded memo of fitness values keyed by genome.
+	// Entries are found by Genome::hash() and confirmed by comparing the whole genome, so hash
+	// collisions never return a wrong weight. When full, the CLOCK policy evicts an entry that
+	// was not looked up since the hand last passed it.
+	class FitnessCache
+	{
+	public:
+		struct Stats
+		{
+			uint64_t hits{0};
+			uint64_t misses{0};
+			uint64_t evictions{0};
+		};
+
+		// capacity is the number of genomes of genomeLength bits kept at most
+		FitnessCache(size_t capacity, size_t genomeLength);
+
+		// hash must be genome.hash(), it is taken as an argument so callers can compute it once
+		std::optional<int> find(const Genome& genome, uint64_t hash);
+		void insert(const Genome& genome, uint64_t hash, int weight);
+		void clear();
+
+		size_t size() const { return m_size; };
+		size_t genomeLength() const { return m_genomeLength; };
+		size_t capacity() const { return m_hashes.size(); };
+		const Stats& stats() const { return m_stats; };
+		void resetStats() { m_stats = {}; };
+
+		// Entries as stored, for checkpoints: size() keys of Genome::wordsForBits(genomeLength()) words each,
+		// with their hashes and weights.
+		const Genome::word_t* keyData() const { return m_keys.data(); };
+		const uint64_t* hashData() const { return m_hashes.data(); };
+		const int* weightData() const { return m_weights.data(); };
+		// replaces the content with entries laid out like keyData(), hashData() and weightData(), up to the capacity
+		void restore(const Genome::word_t* keys, const uint64_t* hashes, const int* weights, size_t count);
+
+	private:
+		static constexpr uint32_t EMPTY = ~uint32_t{0};
+
+		// position in m_index of the entry with the given slot, or the empty position where it would go
+		size_t probe(const Genome& genome, uint64_t hash) const;
+		bool matches(uint32_t slot, const Genome& genome, uint64_t hash) const;
+		uint32_t evict();
+		void eraseFromIndex(size_t pos);
+
+		size_t m_genomeLength;
+		size_t m_words;
+		size_t m_size{0};
+		size_t m_hand{0};
+		// entries, struct-of-arrays indexed by slot
+		std::vector<Genome::word_t, AlignedAllocator<Genome::word_t, Genome::ALIGNMENT>> m_keys;
+		std::vector<uint64_t> m_hashes;
+		std::vector<int> m_weights;
+		std::vector<uint8_t> m_referenced;
+		// open-addressing (linear probing) table of slots
+		std::vector<uint32_t> m_index;
+		size_t m_mask;
+		Stats m_stats;
+	};
+}
+#endif // !OMEGA_FITNESS_CACHE
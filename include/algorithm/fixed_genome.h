@@ -0,0 +1,174 @@
+#ifndef OMEGA_FIXED_GENOME
+#define OMEGA_FIXED_GENOME
+
+#include "algorithm/genome.h"
+#include "algorithm/random.h"
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+
+namespace GeneticAlgorithm
+{
+	// Genome whose length is a template parameter: the same packing as Genome (bit i in word i / 64,
+	// notes LSB first, tail bits zero), kept in a std::array, so it has no heap storage, copies are
+	// plain word copies and every loop over the words has a constant trip count the compiler unrolls.
+	// A 128-bit melody is two words, small enough to live in registers.
+	template<size_t Bits>
+	class FixedGenome
+	{
+		static_assert(Bits > 0, "a genome holds at least one bit");
+
+	public:
+		using word_t = Genome::word_t;
+
+		static constexpr size_t BITS  = Bits;
+		static constexpr size_t WORDS = (Bits + Genome::BITS_PER_WORD - 1) / Genome::BITS_PER_WORD;
+		static constexpr size_t NOTES = Bits / Genome::BITS_PER_NOTE;
+		// valid bits of the last word
+		static constexpr word_t TAIL_MASK = Bits % Genome::BITS_PER_WORD == 0 ? ~word_t{0} : (word_t{1} << (Bits % Genome::BITS_PER_WORD)) - 1;
+
+		constexpr FixedGenome() = default;
+
+		static constexpr size_t size() { return Bits; };
+		static constexpr size_t wordCount() { return WORDS; };
+		static constexpr size_t noteCount() { return NOTES; };
+
+		bool get(size_t idx) const { return (m_words[idx / Genome::BITS_PER_WORD] >> (idx % Genome::BITS_PER_WORD)) & 1u; };
+		bool operator[](size_t idx) const { return get(idx); };
+		void set(size_t idx, bool value)
+		{
+			const word_t bit = word_t{1} << (idx % Genome::BITS_PER_WORD);
+			m_words[idx / Genome::BITS_PER_WORD] = value ? (m_words[idx / Genome::BITS_PER_WORD] | bit) : (m_words[idx / Genome::BITS_PER_WORD] & ~bit);
+		};
+		void flip(size_t idx) { m_words[idx / Genome::BITS_PER_WORD] ^= word_t{1} << (idx % Genome::BITS_PER_WORD); };
+
+		uint8_t nibble(size_t noteIdx) const
+		{
+			return static_cast<uint8_t>((m_words[noteIdx / Genome::NOTES_PER_WORD] >> ((noteIdx % Genome::NOTES_PER_WORD) * Genome::BITS_PER_NOTE)) & 0xF);
+		};
+		void setNibble(size_t noteIdx, uint8_t value)
+		{
+			const size_t shift = (noteIdx % Genome::NOTES_PER_WORD) * Genome::BITS_PER_NOTE;
+			word_t& word	   = m_words[noteIdx / Genome::NOTES_PER_WORD];
+			word			   = (word & ~(word_t{0xF} << shift)) | (word_t{value & 0xFu} << shift);
+		};
+
+		// every note code in order, decoded with a fully unrolled loop
+		std::array<uint8_t, NOTES> notes() const
+		{
+			std::array<uint8_t, NOTES> result{};
+			for (size_t n = 0; n < NOTES; ++n)
+				result[n] = nibble(n);
+			return result;
+		};
+
+		word_t word(size_t idx) const { return m_words[idx]; };
+		void setWord(size_t idx, word_t value) { m_words[idx] = idx + 1 == WORDS ? value & TAIL_MASK : value; };
+
+		// raw word access; callers writing through data() must keep the tail clear (see clearTail)
+		const word_t* data() const { return m_words.data(); };
+		word_t* data() { return m_words.data(); };
+		void clearTail() { m_words[WORDS - 1] &= TAIL_MASK; };
+
+		// same value as Genome::hash() of the same bits
+		uint64_t hash() const
+		{
+			uint64_t h = 0x9E3779B97F4A7C15ull ^ Bits;
+			for (const auto w : m_words)
+			{
+				h ^= w * 0xBF58476D1CE4E5B9ull;
+				h = (h << 31 | h >> 33) * 0x94D049BB133111EBull;
+			}
+			h ^= h >> 33;
+			h *= 0xFF51AFD7ED558CCDull;
+			h ^= h >> 33;
+			return h;
+		};
+
+		bool operator==(const FixedGenome& other) const { return m_words == other.m_words; };
+		bool operator!=(const FixedGenome& other) const { return !(*this == other); };
+
+		// conversions to and from the dynamic genome, e.g. to encode a melody to MIDI
+		GenomeView view() const { return GenomeView(m_words.data(), Bits); };
+		Genome toGenome() const { return Genome(view()); };
+
+		static FixedGenome fromGenome(const Genome& genome)
+		{
+			if (genome.size() != Bits)
+				throw std::runtime_error("FixedGenome::fromGenome error: genome length differs from the fixed length");
+
+			FixedGenome result;
+			for (size_t w = 0; w < WORDS; ++w)
+				result.m_words[w] = genome.word(w);
+			return result;
+		};
+
+	private:
+		std::array<word_t, WORDS> m_words{};
+	};
+
+	// Genetic operators of FixedGenome, with the same semantics as their Genetic counterparts.
+	template<size_t Bits>
+	struct FixedGenetic
+	{
+		using genome_type = FixedGenome<Bits>;
+
+		// uniform index below Bits; a single shift when Bits is a power of two
+		static size_t randomBit(Rng& rng)
+		{
+			if constexpr ((Bits & (Bits - 1)) == 0)
+			{
+				if constexpr (Bits == 1)
+					return 0;
+				else
+					return rng() >> (64 - log2(Bits));
+			}
+			else
+				return rng.uniform(Bits);
+		};
+
+		static genome_type generateGenome(Rng& rng)
+		{
+			genome_type result;
+			rng.fillBits(result.data(), genome_type::WORDS);
+			result.clearTail();
+			return result;
+		};
+
+		// offspring take bits [0, p) from one parent and [p, Bits) from the other;
+		// every word is blended with its own mask, so there is no branch on the cut position
+		static void singlePointCrossover(const genome_type& first, const genome_type& second, genome_type& offspringA, genome_type& offspringB, Rng& rng)
+		{
+			const size_t p = Bits < 2 ? 0 : randomBit(rng);
+
+			for (size_t w = 0; w < genome_type::WORDS; ++w)
+			{
+				const size_t wordStart = w * Genome::BITS_PER_WORD;
+				const size_t lowBits   = p > wordStart ? p - wordStart : 0;
+				const Genome::word_t mask = lowBits >= Genome::BITS_PER_WORD ? ~Genome::word_t{0} : (Genome::word_t{1} << lowBits) - 1;
+
+				const Genome::word_t f = first.word(w);
+				const Genome::word_t s = second.word(w);
+				offspringA.data()[w]   = (f & mask) | (s & ~mask);
+				offspringB.data()[w]   = (s & mask) | (f & ~mask);
+			}
+		};
+
+		static void mutation(genome_type& genome, size_t num, float probability, Rng& rng)
+		{
+			const double threshold = static_cast<double>(probability);
+			for (size_t i = 0; i < num; ++i)
+			{
+				const auto p	= rng.uniformReal();
+				const auto idx	= randomBit(rng);
+
+				if (p < threshold)
+					genome.flip(idx);
+			}
+		};
+
+	private:
+		static constexpr int log2(size_t value) { return value <= 1 ? 0 : 1 + log2(value / 2); };
+	};
+}
+#endif // !OMEGA_FIXED_GENOME
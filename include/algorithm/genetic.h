@@ -1,34 +1,97 @@
 #ifndef OMEGA_GENETIC
 #define OMEGA_GENETIC
 
+#include "algorithm/genome.h"
+#include "algorithm/incremental_fitness.h"
+#include "algorithm/random.h"
+#include "utility/span.h"
+#include "utility/thread_pool.h"
 #include <vector>
 #include <map>
 #include <array>
 #include <tuple>
 #include <functional>
 
+// defaults for EvolutionConfig, both can be changed at runtime
 constexpr uint16_t GENOME_LENGTH = 128;
 constexpr uint8_t GENOMES_IN_POPULATION = 6;
 
 namespace GeneticAlgorithm
 {
-	using Genome = std::vector<bool>;
 	using Population = std::vector<Genome>;
-	using WeightedPopulation = std::array<std::pair<uint16_t, uint16_t>, GENOMES_IN_POPULATION>; // index to weight mapping
-	using FitnessFunc = std::function<int(Genome)>;
+	using WeightedPopulation = std::vector<std::pair<uint32_t, int>>; // index to weight mapping, sorted by weight
+	using FitnessFunc = std::function<int(const Genome&)>;
+	// scores genomes[i] into weights[i]; may be called concurrently on disjoint sub-spans
+	using BatchFitnessFunc = std::function<void(utility::Span<const Genome> genomes, utility::Span<int> weights)>;
+	// parents of offspring pair k as population indices
+	using ParentPairs = std::vector<std::pair<uint32_t, uint32_t>>;
+
+	// how Genetic::crossover() splits the parents
+	enum class CrossoverType
+	{
+		SINGLE_POINT, // one cut at any bit
+		TWO_POINT,	  // the bits between two cuts are exchanged
+		UNIFORM,	  // every bit comes from either parent with probability 0.5
+		NOTE_ALIGNED, // one cut between two notes
+		BAR_ALIGNED	  // one cut between two bars of Genome::NOTES_PER_BAR notes
+	};
 
 	struct Genetic
 	{
+		// operators without an Rng argument draw from Random::threadRng()
 		static Genome generateGenome(size_t genomeLength);
+		static Genome generateGenome(size_t genomeLength, Rng& rng);
 		static Population generatePopulation(size_t populationSize = GENOMES_IN_POPULATION, size_t genomeLength = GENOME_LENGTH);
+		static Population generatePopulation(size_t populationSize, size_t genomeLength, Rng& rng);
+		// the offspring are built in the parents' storage, so parents passed as rvalues are not copied
 		static std::tuple<Genome, Genome> singlePointCrossover(Genome first, Genome second);
+		static std::tuple<Genome, Genome> singlePointCrossover(Genome first, Genome second, Rng& rng);
+		// writes the offspring into existing genomes, reusing their storage; they must not be the parents
+		static void singlePointCrossover(GenomeView first, GenomeView second, Genome& offspringA, Genome& offspringB, Rng& rng);
+		// The crossovers below share the contract of the one above. Every word of the offspring is a mask blend
+		// of the parents' words, so none of them walks the genome bit by bit.
+		static void twoPointCrossover(GenomeView first, GenomeView second, Genome& offspringA, Genome& offspringB, Rng& rng);
+		// one random 64-bit mask per word decides which parent every bit comes from
+		static void uniformCrossover(GenomeView first, GenomeView second, Genome& offspringA, Genome& offspringB, Rng& rng);
+		// single point cut that never splits a note (or a bar), so the offspring only contain the parents' notes
+		static void noteAlignedCrossover(GenomeView first, GenomeView second, Genome& offspringA, Genome& offspringB, Rng& rng);
+		static void barAlignedCrossover(GenomeView first, GenomeView second, Genome& offspringA, Genome& offspringB, Rng& rng);
+		static void crossover(CrossoverType type, GenomeView first, GenomeView second, Genome& offspringA, Genome& offspringB, Rng& rng);
+		// offspring[2 * k] and offspring[2 * k + 1] are bred from the parents pairs[k] of population;
+		// offspring must hold twice as many genomes as there are pairs and must not overlap population
+		static void crossover(CrossoverType type, const Population& population, const ParentPairs& pairs, utility::Span<Genome> offspring, Rng& rng);
 		static void mutation(Genome& genome, size_t num = 1, float probability = 0.5);
-		static int populationFitness();
-		static std::tuple<Genome, Genome> selectionPair(const Population& population);
-		static void generateWeightedDistribution(const Population& population, FitnessFunc fitnessFunc);
-		static Population sortPopulation(const Population& population, FitnessFunc fitnessFunc, bool reversed = true);
-		static uint16_t getMaxWeight();
-		//static Population runEvolution(FitnessFunc fitnessFunc, uint32_t fitnessLimit, uint32_t generationLimit = 100);
+		static void mutation(Genome& genome, size_t num, float probability, Rng& rng);
+		static void mutation(utility::Span<Genome> genomes, size_t num, float probability, Rng& rng);
+		// Flips every bit independently with probability rate and returns how many bits flipped. The distance to
+		// the next flip is drawn from the geometric distribution, so the generator is used once per flip, not per bit.
+		static size_t flipMutation(Genome& genome, double rate, Rng& rng);
+		// the same over all bits of genomes, which are skipped across as one sequence
+		static size_t flipMutation(utility::Span<Genome> genomes, double rate, Rng& rng);
+		static int populationFitness(const WeightedPopulation& weightedPopulation);
+		// views of the selected parents in population, nothing is copied
+		static std::tuple<GenomeView, GenomeView> selectionPair(const Population& population, const WeightedPopulation& weightedPopulation);
+		static std::tuple<GenomeView, GenomeView> selectionPair(const Population& population, const WeightedPopulation& weightedPopulation, Rng& rng);
+		// roulette selection of two parents, returned as population indices; negative weights count as 0
+		static std::pair<size_t, size_t> selectionPairIndices(const WeightedPopulation& weightedPopulation, Rng& rng);
+		static void generateWeightedDistribution(const Population& population, const FitnessFunc& fitnessFunc, WeightedPopulation& weightedPopulation);
+		static void generateWeightedDistribution(const Population& population, const BatchFitnessFunc& fitnessFunc, utility::ThreadPool& pool, WeightedPopulation& weightedPopulation);
+		// builds the weighted population from weights[i] of population[i]
+		static void weightPopulation(const std::vector<int>& weights, WeightedPopulation& weightedPopulation);
+		// genomes ordered by a weighted population built from the same population; copies every genome
+		static Population sortPopulation(const Population& population, const WeightedPopulation& weightedPopulation, bool reversed = true);
+		static Population sortPopulation(const Population& population, const FitnessFunc& fitnessFunc, WeightedPopulation& weightedPopulation, bool reversed = true);
+		// the same order as views into population, without copying genomes
+		static void sortPopulation(const Population& population, const WeightedPopulation& weightedPopulation, std::vector<GenomeView>& sorted, bool reversed = true);
+		// Reorders population in place by moving the genomes along the index permutation of weightedPopulation,
+		// then renumbers weightedPopulation so that it still indexes the same genomes.
+		static void permutePopulation(Population& population, WeightedPopulation& weightedPopulation, bool reversed = true);
+		// scores the population on the pool, weights[i] always belongs to population[i]
+		static void evaluatePopulation(const Population& population, const BatchFitnessFunc& fitnessFunc, utility::ThreadPool& pool, std::vector<int>& weights, size_t grain = 0);
+		static void evaluatePopulation(utility::Span<const Genome> genomes, const BatchFitnessFunc& fitnessFunc, utility::ThreadPool& pool, utility::Span<int> weights, size_t grain = 0);
+		// Writes the runs of notes in which genome differs from base to ranges and returns how many there are.
+		// Runs less than a word apart are merged, and once ranges is full the last range grows to cover the rest.
+		static size_t changedNotes(GenomeView base, GenomeView genome, utility::Span<NoteRange> ranges);
 	};
 }
 #endif // !OMEGA_GENETIC
\ No newline at end of file
@@ -0,0 +1,186 @@
+#ifndef OMEGA_GENOME
+#define OMEGA_GENOME
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace GeneticAlgorithm
+{
+	// allocator returning storage aligned to a cache line, so word loops never straddle lines
+	template<typename T, size_t Alignment>
+	struct AlignedAllocator
+	{
+		using value_type = T;
+
+		template<typename U>
+		struct rebind
+		{
+			using other = AlignedAllocator<U, Alignment>;
+		};
+
+		AlignedAllocator() noexcept = default;
+		template<typename U>
+		AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+		T* allocate(size_t n)
+		{
+			return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+		}
+
+		void deallocate(T* p, size_t) noexcept
+		{
+			::operator delete(p, std::align_val_t(Alignment));
+		}
+
+		template<typename U>
+		bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+		template<typename U>
+		bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept { return false; }
+	};
+
+	class GenomeView;
+	struct NoteEvents;
+
+	// Genome packed into 64-bit words.
+	// Bit i is stored in word i / 64 at position i % 64. Every 4 bits form a note (nibble),
+	// the first bit of a note being its least significant bit, so one word holds 16 notes.
+	// Bits past size() in the last word are always zero.
+	// The decoded notes are cached with the bits; every non-const member drops them.
+	class Genome
+	{
+	public:
+		using word_t = uint64_t;
+
+		static constexpr size_t BITS_PER_WORD  = 64;
+		static constexpr size_t BITS_PER_NOTE  = 4;
+		static constexpr size_t NOTES_PER_WORD = BITS_PER_WORD / BITS_PER_NOTE;
+		// MidiEncoder writes 4/4 with one quarter per note
+		static constexpr size_t NOTES_PER_BAR  = 4;
+		static constexpr size_t BITS_PER_BAR   = NOTES_PER_BAR * BITS_PER_NOTE;
+		static constexpr size_t ALIGNMENT	   = 64;
+
+		Genome() = default;
+		explicit Genome(size_t length, bool value = false);
+		// deep copy of the viewed bits
+		explicit Genome(GenomeView view);
+
+		// copies the viewed bits, reusing the storage when the length matches
+		void assign(GenomeView view);
+
+		// copies take the bits only, a moved genome keeps its decoded notes
+		Genome(const Genome& other);
+		Genome& operator=(const Genome& other);
+		Genome(Genome&& other) noexcept;
+		Genome& operator=(Genome&& other) noexcept;
+		~Genome();
+
+		size_t size() const { return m_length; };
+		bool empty() const { return m_length == 0; };
+		size_t wordCount() const { return m_words.size(); };
+		size_t noteCount() const { return m_length / BITS_PER_NOTE; };
+		void resize(size_t length);
+
+		bool get(size_t idx) const { return (m_words[idx / BITS_PER_WORD] >> (idx % BITS_PER_WORD)) & 1u; };
+		bool operator[](size_t idx) const { return get(idx); };
+		void set(size_t idx, bool value);
+		void flip(size_t idx)
+		{
+			dropNoteEvents();
+			m_words[idx / BITS_PER_WORD] ^= word_t{1} << (idx % BITS_PER_WORD);
+		};
+
+		uint8_t nibble(size_t noteIdx) const
+		{
+			return static_cast<uint8_t>((m_words[noteIdx / NOTES_PER_WORD] >> ((noteIdx % NOTES_PER_WORD) * BITS_PER_NOTE)) & 0xF);
+		};
+		void setNibble(size_t noteIdx, uint8_t value);
+
+		word_t word(size_t idx) const { return m_words[idx]; };
+		void setWord(size_t idx, word_t value);
+
+		// raw word access; callers writing through data() must keep the tail clear (see clearTail)
+		const word_t* data() const { return m_words.data(); };
+		word_t* data()
+		{
+			dropNoteEvents();
+			return m_words.data();
+		};
+
+		// zeroes the unused bits of the last word
+		void clearTail();
+		// mask of valid bits in the last word
+		word_t tailMask() const;
+
+		// fast non-cryptographic hash of the bits
+		uint64_t hash() const;
+
+		// Notes of the genome, decoded on the first call after the bits last changed. Concurrent calls on a
+		// genome nobody modifies are safe; the result is valid until the genome changes or is destroyed.
+		const NoteEvents& noteEvents() const;
+
+		bool operator==(const Genome& other) const { return m_length == other.m_length && m_words == other.m_words; };
+		bool operator!=(const Genome& other) const { return !(*this == other); };
+
+		static size_t wordsForBits(size_t length) { return (length + BITS_PER_WORD - 1) / BITS_PER_WORD; };
+
+	private:
+		// the check keeps the common case, nothing decoded, free of atomic read-modify-writes
+		void dropNoteEvents()
+		{
+			if (m_noteEvents.load(std::memory_order_acquire))
+				releaseNoteEvents();
+		};
+		void releaseNoteEvents();
+
+		std::vector<word_t, AlignedAllocator<word_t, ALIGNMENT>> m_words;
+		size_t m_length{0};
+		// owned, published once by noteEvents() with a compare-exchange
+		mutable std::atomic<const NoteEvents*> m_noteEvents{nullptr};
+	};
+
+	// Non-owning read-only view of bits packed like a Genome: a Genome, a FixedGenome or genome words
+	// mapped from a checkpoint. Copying a view copies two fields; it is valid as long as the viewed words.
+	class GenomeView
+	{
+	public:
+		using word_t = Genome::word_t;
+
+		GenomeView() = default;
+		// words must hold wordsForBits(length) words with a clear tail
+		GenomeView(const word_t* words, size_t length) : m_words(words), m_length(length) {};
+		GenomeView(const Genome& genome) : m_words(genome.data()), m_length(genome.size()) {};
+
+		size_t size() const { return m_length; };
+		bool empty() const { return m_length == 0; };
+		size_t wordCount() const { return Genome::wordsForBits(m_length); };
+		size_t noteCount() const { return m_length / Genome::BITS_PER_NOTE; };
+
+		bool get(size_t idx) const { return (m_words[idx / Genome::BITS_PER_WORD] >> (idx % Genome::BITS_PER_WORD)) & 1u; };
+		bool operator[](size_t idx) const { return get(idx); };
+		uint8_t nibble(size_t noteIdx) const
+		{
+			return static_cast<uint8_t>((m_words[noteIdx / Genome::NOTES_PER_WORD] >> ((noteIdx % Genome::NOTES_PER_WORD) * Genome::BITS_PER_NOTE)) & 0xF);
+		};
+		word_t word(size_t idx) const { return m_words[idx]; };
+		const word_t* data() const { return m_words; };
+
+		// same value as Genome::hash() of the same bits
+		uint64_t hash() const;
+
+		bool operator==(const GenomeView& other) const
+		{
+			return m_length == other.m_length && std::equal(m_words, m_words + wordCount(), other.m_words);
+		};
+		bool operator!=(const GenomeView& other) const { return !(*this == other); };
+
+	private:
+		const word_t* m_words{nullptr};
+		size_t m_length{0};
+	};
+}
+#endif // !OMEGA_GENOME
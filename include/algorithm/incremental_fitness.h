@@ -0,0 +1,36 @@
+#ifndef OMEGA_INCREMENTAL_FITNESS
+#define OMEGA_INCREMENTAL_FITNESS
+
+#include "algorithm/genome.h"
+#include "utility/span.h"
+#include <cstddef>
+
+namespace GeneticAlgorithm
+{
+	// notes [first, last) of a genome
+	struct NoteRange
+	{
+		size_t first{0};
+		size_t last{0};
+	};
+
+	// Fitness derived from a fixed-size summary of the genome, which a scorer can bring up to date from the notes
+	// that changed instead of scanning the whole genome again. Evolution keeps the summary of every genome and,
+	// after breeding, hands the scorer an offspring together with the parent it differs from the least.
+	// The summary is stateSize() bytes of trivially copyable data; it is copied with memcpy and may be unaligned.
+	class IncrementalFitness
+	{
+	public:
+		virtual ~IncrementalFitness() = default;
+
+		virtual size_t stateSize() const = 0;
+
+		// writes the summary of genome to state and returns its weight
+		virtual int evaluate(const Genome& genome, void* state) const = 0;
+
+		// Same as evaluate(genome, state), given the summary of base, a genome of the same length equal to genome
+		// outside the changed ranges. The ranges are sorted and disjoint; baseState and state do not overlap.
+		virtual int update(const Genome& base, const void* baseState, const Genome& genome, utility::Span<const NoteRange> changed, void* state) const = 0;
+	};
+}
+#endif // !OMEGA_INCREMENTAL_FITNESS
@@ -0,0 +1,94 @@
+#ifndef OMEGA_ISLAND
+#define OMEGA_ISLAND
+
+#include "algorithm/evolution.h"
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace GeneticAlgorithm
+{
+	enum class MigrationTopology
+	{
+		RING,  // island i sends to island i + 1
+		RANDOM // every island receives from a randomly drawn other island
+	};
+
+	struct IslandConfig
+	{
+		// config of every island; when seed is set, island i is seeded with stream i of it
+		EvolutionConfig evolution{};
+		// 0 uses one island per hardware thread
+		size_t islands				= 0;
+		uint32_t migrationInterval	= 10;
+		size_t migrants				= 2;
+		MigrationTopology topology	= MigrationTopology::RING;
+	};
+
+	// Island model: independent Evolution instances, each on its own thread, that periodically
+	// send copies of their best genomes to another island. Emigrants go through a single-slot mailbox
+	// per island claimed with atomic compare-and-swap: a batch not picked up yet is replaced by the newer one,
+	// and an island whose mailbox is being read skips that migration, so no island ever waits for another.
+	class IslandModel
+	{
+	public:
+		struct Stats
+		{
+			uint64_t delivered{0}; // batches of migrants taken in by an island
+			uint64_t dropped{0};   // batches lost, either replaced before pickup or not sent while the mailbox was read
+		};
+
+		explicit IslandModel(const IslandConfig& config);
+		~IslandModel();
+
+		IslandModel(const IslandModel&) = delete;
+		IslandModel& operator=(const IslandModel&) = delete;
+
+		size_t size() const { return m_islands.size(); };
+		const Evolution& island(size_t idx) const { return m_islands[idx]->evolution; };
+
+		// Evolves all islands concurrently until one reaches fitnessLimit or each evaluated generationLimit generations.
+		// fitnessFunc is called from all island threads at once and must be thread-safe. The first exception
+		// thrown on an island stops the others and is rethrown here once every island thread has finished.
+		void run(const FitnessFunc& fitnessFunc, int fitnessLimit, uint32_t generationLimit = 100);
+
+		// best genome over all islands after run()
+		const Genome& best() const;
+		int maxWeight() const;
+		Stats stats() const { return {m_delivered.load(), m_dropped.load()}; };
+
+	private:
+		enum MailboxState : int
+		{
+			EMPTY,
+			WRITING,
+			FULL,
+			READING
+		};
+
+		struct Island
+		{
+			explicit Island(const EvolutionConfig& config) : evolution(config) {}
+
+			Evolution evolution;
+			Population outbox;
+			std::atomic<int> outboxState{EMPTY};
+		};
+
+		void runIsland(size_t idx, const FitnessFunc& fitnessFunc, int fitnessLimit, uint32_t generationLimit);
+		void evolveIsland(size_t idx, const FitnessFunc& fitnessFunc, int fitnessLimit, uint32_t generationLimit);
+		void emigrate(Island& island);
+		void immigrate(size_t idx);
+
+		IslandConfig m_config;
+		std::vector<std::unique_ptr<Island>> m_islands;
+		std::atomic<bool> m_stop{false};
+		std::mutex m_errorMutex;
+		std::exception_ptr m_error;
+		std::atomic<uint64_t> m_delivered{0};
+		std::atomic<uint64_t> m_dropped{0};
+	};
+}
+#endif // !OMEGA_ISLAND
@@ -0,0 +1,102 @@
+#ifndef OMEGA_METRICS
+#define OMEGA_METRICS
+
+#include "algorithm/genetic.h"
+#include "algorithm/incremental_fitness.h"
+#include "scale.h"
+#include <array>
+#include <cstdint>
+
+namespace GeneticAlgorithm
+{
+	// Built-in objective metrics of a melody, each scored from 0 to METRIC_MAX.
+	enum class Metric
+	{
+		SCALE_ADHERENCE, // share of sounded notes on a tonic triad tone of the scale
+		SMOOTHNESS,		 // share of adjacent sounded notes at most maxStep scale degrees apart
+		PAUSES,			 // closeness of the pause (0000) share to pauseTarget
+		CONTINUATIONS,	 // closeness of the continuation (1111) share to continuationTarget
+		DENSITY,		 // closeness of the share of notes starting a sound to densityTarget
+		REPETITION,		 // closeness of the share of notes equal to the note a bar earlier to repetitionTarget
+		COUNT
+	};
+
+	static constexpr int METRIC_MAX = 1000;
+
+	// Note counts of one genome, everything the metrics are derived from.
+	struct NoteStats
+	{
+		uint32_t notes{0};
+		uint32_t pauses{0};
+		uint32_t continuations{0};
+		uint32_t sounded{0};	   // notes 0001 - 1110
+		uint32_t triadTones{0};	   // sounded notes on a tonic triad tone
+		uint32_t pairs{0};		   // adjacent pairs of sounded notes
+		uint32_t smoothPairs{0};   // of them at most maxStep degrees apart
+		uint32_t barNotes{0};	   // notes having a note one bar earlier
+		uint32_t repeatedNotes{0}; // of them equal to that note
+	};
+
+	struct MetricParams
+	{
+		// widest interval in scale degrees still counted as smooth, at most 13
+		uint32_t maxStep			= 2;
+		double pauseTarget			= 0.1;
+		double continuationTarget	= 0.15;
+		double densityTarget		= 0.75;
+		double repetitionTarget		= 0.5;
+	};
+
+	using MetricWeights = std::array<double, static_cast<size_t>(Metric::COUNT)>;
+
+	// Weighted composite of the built-in metrics.
+	// The genome is scanned a 64-bit word at a time with SWAR tricks, 16 notes per operation,
+	// and a single pass collects the counts of all metrics. A bar is Genome::NOTES_PER_BAR notes.
+	// fitnessFunc() scores a whole batch per call, so Evolution pays for one std::function call per generation.
+	// As an IncrementalFitness its summary is the NoteStats of a genome: every count is a sum over notes of
+	// what note n, the note after it and the note a bar before it hold, so a change is recounted around itself.
+	class MelodyScorer : public IncrementalFitness
+	{
+	public:
+		// equal weights by default
+		explicit MelodyScorer(const Scale& scale, const MetricWeights& weights = uniformWeights(), const MetricParams& params = {});
+
+		const MetricWeights& weights() const { return m_weights; };
+		const MetricParams& params() const { return m_params; };
+
+		NoteStats countNotes(const Genome& genome) const;
+		// counts taken at notes [first, last) only, with notes left at 0
+		NoteStats countNotes(const Genome& genome, size_t first, size_t last) const;
+		// stats of genome from baseStats of base, a genome of the same length equal to it outside the changed ranges
+		NoteStats updateNotes(const NoteStats& baseStats, const Genome& base, const Genome& genome, utility::Span<const NoteRange> changed) const;
+		int metric(Metric metric, const NoteStats& stats) const;
+
+		// weighted mean of the metrics, from 0 to METRIC_MAX
+		int score(const Genome& genome) const;
+		int score(const NoteStats& stats) const;
+		void score(utility::Span<const Genome> genomes, utility::Span<int> weights) const;
+		// a single metric of every genome
+		void score(Metric metric, utility::Span<const Genome> genomes, utility::Span<int> weights) const;
+
+		// the scorer is copied into the returned functions
+		BatchFitnessFunc fitnessFunc() const;
+		FitnessFunc genomeFitnessFunc() const;
+
+		size_t stateSize() const override { return sizeof(NoteStats); };
+		int evaluate(const Genome& genome, void* state) const override;
+		int update(const Genome& base, const void* baseState, const Genome& genome, utility::Span<const NoteRange> changed, void* state) const override;
+
+		static MetricWeights uniformWeights();
+		static MetricWeights singleWeight(Metric metric);
+
+	private:
+		MetricWeights m_weights;
+		MetricParams m_params;
+		double m_totalWeight{0.0};
+
+		// every nibble of the word set to a tonic triad code
+		std::array<uint64_t, 14> m_triadCodes{};
+		size_t m_triadCount{0};
+	};
+}
+#endif // !OMEGA_METRICS
@@ -0,0 +1,55 @@
+#ifndef OMEGA_NGRAM
+#define OMEGA_NGRAM
+
+#include "algorithm/genetic.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace GeneticAlgorithm
+{
+	// n-gram model of note codes (scale degrees, 0000 and 1111 included) trained on a corpus.
+	// The model is one flat table of 16^order log-probabilities in fixed point, indexed by the n-gram itself:
+	// note i + j of the n-gram sits in bits 4j..4j+3 of the index, the same order the notes are packed in
+	// a Genome, so scoring slides a window over the packed words and reads one entry per note.
+	// order 4 makes a 128 KiB table, small enough to stay in cache.
+	// Copies share the table; a loaded model reads it straight from the mapped file.
+	class NGramModel
+	{
+	public:
+		static constexpr uint32_t MAX_ORDER = 5;
+		// table entries are log2 of the probability times LOG_SCALE
+		static constexpr int LOG_SCALE = 256;
+
+		// Counts the n-grams of the corpus; probabilities are add-`smoothing` estimates of a note given
+		// the order - 1 notes before it.
+		static NGramModel train(utility::Span<const Genome> corpus, uint32_t order = 4, double smoothing = 0.5);
+
+		// memory-maps a model written by save()
+		static NGramModel load(const std::string& path);
+		void save(const std::string& path) const;
+
+		uint32_t order() const { return m_order; };
+		size_t tableSize() const { return size_t{1} << (4 * m_order); };
+		// log2 of the probability of the last note of an n-gram given the others, times LOG_SCALE
+		int16_t entry(size_t ngram) const { return m_table[ngram]; };
+
+		// sum of the entries of all n-grams of the genome
+		int64_t logLikelihood(const Genome& genome) const;
+		// geometric mean of the note probabilities, from 0 to 1000; 0 for genomes shorter than the order
+		int score(const Genome& genome) const;
+		void score(utility::Span<const Genome> genomes, utility::Span<int> weights) const;
+
+		// the model is copied into the returned functions
+		BatchFitnessFunc fitnessFunc() const;
+		FitnessFunc genomeFitnessFunc() const;
+
+	private:
+		NGramModel(uint32_t order, std::shared_ptr<const void> storage, const int16_t* table);
+
+		uint32_t m_order;
+		std::shared_ptr<const void> m_storage; // owns the table: a vector or a mapped file
+		const int16_t* m_table;
+	};
+}
+#endif // !OMEGA_NGRAM
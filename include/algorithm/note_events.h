@@ -0,0 +1,31 @@
+#ifndef OMEGA_NOTE_EVENTS
+#define OMEGA_NOTE_EVENTS
+
+#include "algorithm/genome.h"
+#include <cstdint>
+#include <vector>
+
+namespace GeneticAlgorithm
+{
+	// Notes of a genome decoded once, as structure of arrays with one entry per sounded note.
+	// Codes 0001 - 1110 start scale degrees 1 - 14, 0000 is a rest and 1111 holds whatever sounds (or rests)
+	// before it one note longer, so a note lasts from its code through the continuations after it.
+	// Times count genome notes (quarters); pitches come from looking the degree up in a Scale.
+	// Genome::noteEvents() keeps the decoded notes of a genome until its bits change.
+	struct NoteEvents
+	{
+		std::vector<uint8_t> degrees;	 // note code 1 - 14
+		std::vector<uint32_t> starts;	 // note the sound starts at
+		std::vector<uint32_t> durations; // notes it lasts, continuations included
+		uint32_t length{0};				 // notes of the genome, trailing rests included
+
+		size_t size() const { return degrees.size(); };
+		bool empty() const { return degrees.empty(); };
+		// note the last sound ends at, length when the melody does not end in a rest
+		uint32_t end() const { return empty() ? 0 : starts.back() + durations.back(); };
+
+		// replaces the contents of events, keeping the capacity of its arrays
+		static void decode(GenomeView genome, NoteEvents& events);
+	};
+}
+#endif // !OMEGA_NOTE_EVENTS
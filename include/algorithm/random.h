@@ -0,0 +1,78 @@
+#ifndef OMEGA_RANDOM
+#define OMEGA_RANDOM
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <limits>
+
+namespace GeneticAlgorithm
+{
+	// xoshiro256** generator (https://prng.di.unimi.it/).
+	// Satisfies UniformRandomBitGenerator, so it can also drive <random> distributions.
+	class Rng
+	{
+	public:
+		using result_type = uint64_t;
+		using state_t	  = std::array<uint64_t, 4>;
+
+		explicit Rng(uint64_t seed = 0);
+
+		// independent generator for stream `stream` of the master seed `seed`
+		static Rng forStream(uint64_t seed, uint64_t stream);
+
+		static constexpr result_type min() { return 0; };
+		static constexpr result_type max() { return std::numeric_limits<result_type>::max(); };
+
+		result_type operator()()
+		{
+			const uint64_t result = rotl(m_state[1] * 5, 7) * 9;
+			const uint64_t t	  = m_state[1] << 17;
+
+			m_state[2] ^= m_state[0];
+			m_state[3] ^= m_state[1];
+			m_state[1] ^= m_state[2];
+			m_state[0] ^= m_state[3];
+			m_state[2] ^= t;
+			m_state[3] = rotl(m_state[3], 45);
+
+			return result;
+		};
+
+		// uniform integer in [0, bound), bound must be > 0
+		uint64_t uniform(uint64_t bound);
+		// uniform double in [0, 1)
+		double uniformReal() { return static_cast<double>((*this)() >> 11) * 0x1.0p-53; };
+		bool bernoulli(double p) { return uniformReal() < p; };
+
+		// fills `count` words with random bits, each bit set with probability 0.5
+		void fillBits(uint64_t* words, size_t count);
+
+		// advances the generator by 2^128 steps
+		void jump();
+
+		const state_t& state() const { return m_state; };
+		void setState(const state_t& state) { m_state = state; };
+
+	private:
+		static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); };
+
+		state_t m_state;
+	};
+
+	namespace Random
+	{
+		// Sets the master seed all thread and stream generators are derived from.
+		// Thread generators pick up the new seed on their next use.
+		void setMasterSeed(uint64_t seed);
+		uint64_t masterSeed();
+
+		// Generator owned by the calling thread. Streams are assigned to threads in the order
+		// the threads first draw from it, so use streamRng() where the result must not depend on scheduling.
+		Rng& threadRng();
+
+		// generator for a fixed stream (e.g. a genome index) of the master seed
+		Rng streamRng(uint64_t stream);
+	}
+}
+#endif // !OMEGA_RANDOM
@@ -0,0 +1,53 @@
+#ifndef OMEGA_SELECTION
+#define OMEGA_SELECTION
+
+#include "algorithm/genetic.h"
+#include <utility>
+#include <vector>
+
+namespace GeneticAlgorithm
+{
+	enum class SelectionStrategy
+	{
+		ALIAS,		// fitness-proportionate, O(1) per draw after an O(N) build (Vose's alias method)
+		PREFIX_SUM, // fitness-proportionate, O(log N) per draw by binary search over cumulative weights
+		TOURNAMENT	// best of k uniformly drawn genomes, ignores the weight scale
+	};
+
+	// Draws parents as population indices.
+	// prepare() is called once per generation; the draws then only read the tables it built.
+	// The proportionate strategies count negative weights as zero and draw uniformly when no weight is positive.
+	class Selector
+	{
+	public:
+		explicit Selector(SelectionStrategy strategy = SelectionStrategy::ALIAS, size_t tournamentSize = 2);
+
+		SelectionStrategy strategy() const { return m_strategy; };
+
+		void prepare(const WeightedPopulation& weightedPopulation);
+
+		size_t select(Rng& rng) const;
+		std::pair<size_t, size_t> selectPair(Rng& rng) const { return {select(rng), select(rng)}; };
+		// replaces the content of pairs with `count` parent pairs, reusing its storage
+		void selectPairs(size_t count, Rng& rng, ParentPairs& pairs) const;
+
+	private:
+		size_t selectAlias(Rng& rng) const;
+		size_t selectPrefixSum(Rng& rng) const;
+		size_t selectTournament(Rng& rng) const;
+
+		SelectionStrategy m_strategy;
+		size_t m_tournamentSize;
+		uint64_t m_totalWeight{0};
+
+		std::vector<int> m_weights; // by population index
+		// alias table
+		std::vector<double> m_probability;
+		std::vector<uint32_t> m_alias;
+		std::vector<uint32_t> m_small;
+		std::vector<uint32_t> m_large;
+		// cumulative weights by population index
+		std::vector<uint64_t> m_prefix;
+	};
+}
+#endif // !OMEGA_SELECTION
@@ -0,0 +1,177 @@
+#ifndef OMEGA_STATIC_EVOLUTION
+#define OMEGA_STATIC_EVOLUTION
+
+#include "algorithm/fixed_genome.h"
+#include "algorithm/genetic.h"
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+namespace GeneticAlgorithm
+{
+	// melodies of the default length
+	using MelodyGenome = FixedGenome<GENOME_LENGTH>;
+
+	struct StaticEvolutionConfig
+	{
+		// unset draws a seed from Random::threadRng()
+		std::optional<uint64_t> seed{};
+		// best genomes copied unchanged into the next generation
+		size_t elites			  = 2;
+		size_t mutationCount	  = 1;
+		float mutationProbability = 0.5f;
+	};
+
+	// Evolution with the genome length, population size and fitness function fixed at compile time.
+	// Populations and weights are std::arrays and the fitness functor, called as int(const FixedGenome<Bits>&),
+	// is a template parameter, so it is inlined into evaluate() instead of going through std::function.
+	// Selection is fitness-proportionate (negative weights count as 0, all-zero weights select uniformly),
+	// the same as the PREFIX_SUM strategy of Evolution. Nothing is allocated after construction.
+	template<size_t Bits, size_t PopulationSize, typename Fitness>
+	class StaticEvolution
+	{
+		static_assert(PopulationSize >= 2, "population must contain at least 2 genomes");
+
+	public:
+		using genome_type	  = FixedGenome<Bits>;
+		using population_type = std::array<genome_type, PopulationSize>;
+		using weights_type	  = std::array<int, PopulationSize>;
+
+		explicit StaticEvolution(Fitness fitness, const StaticEvolutionConfig& config = {}) :
+			m_fitness(std::move(fitness)), m_config(config), m_rng(config.seed ? *config.seed : Random::threadRng()())
+		{
+			if (m_config.elites > PopulationSize)
+				throw std::runtime_error("StaticEvolution error: more elites than genomes in population");
+		}
+
+		const StaticEvolutionConfig& config() const { return m_config; };
+		const population_type& population() const { return m_population; };
+		population_type& population() { return m_population; };
+		// weights()[i] is the weight of population()[i] after evaluate()
+		const weights_type& weights() const { return m_weights; };
+		Rng& rng() { return m_rng; };
+		uint64_t generation() const { return m_generation; };
+
+		void initPopulation()
+		{
+			for (auto& genome : m_population)
+				genome = FixedGenetic<Bits>::generateGenome(m_rng);
+			m_evaluated	 = false;
+			m_generation = 0;
+		};
+
+		void evaluate()
+		{
+			for (size_t i = 0; i < PopulationSize; ++i)
+				m_weights[i] = m_fitness(m_population[i]);
+
+			// only the elites and the best need ordering: they lead m_order by descending weight
+			for (size_t i = 0; i < PopulationSize; ++i)
+				m_order[i] = static_cast<uint32_t>(i);
+			const size_t ranked = std::max<size_t>(m_config.elites, 1);
+			std::partial_sort(m_order.begin(), m_order.begin() + ranked, m_order.end(),
+							  [&](uint32_t a, uint32_t b) { return m_weights[a] != m_weights[b] ? m_weights[a] > m_weights[b] : a < b; });
+
+			uint64_t sum = 0;
+			for (size_t i = 0; i < PopulationSize; ++i)
+			{
+				sum += static_cast<uint64_t>(std::max(m_weights[i], 0));
+				m_prefix[i] = sum;
+			}
+			m_evaluated = true;
+		};
+
+		void breed()
+		{
+			if (!m_evaluated)
+				throw std::runtime_error("StaticEvolution::breed error: population must be evaluated first");
+
+			size_t slot = 0;
+			for (; slot < m_config.elites; ++slot)
+				m_next[slot] = m_population[m_order[slot]];
+
+			for (; slot < PopulationSize; slot += 2)
+			{
+				const size_t first	= select();
+				const size_t second = select();
+
+				genome_type& offspringA = m_next[slot];
+				genome_type& offspringB = slot + 1 < PopulationSize ? m_next[slot + 1] : m_spare;
+
+				FixedGenetic<Bits>::singlePointCrossover(m_population[first], m_population[second], offspringA, offspringB, m_rng);
+				FixedGenetic<Bits>::mutation(offspringA, m_config.mutationCount, m_config.mutationProbability, m_rng);
+				FixedGenetic<Bits>::mutation(offspringB, m_config.mutationCount, m_config.mutationProbability, m_rng);
+			}
+
+			std::swap(m_population, m_next);
+			m_evaluated = false;
+			++m_generation;
+		};
+
+		// Evaluates and breeds until a genome reaches fitnessLimit or generationLimit generations were evaluated;
+		// returns the last evaluated population.
+		const population_type& run(int fitnessLimit, uint32_t generationLimit = 100)
+		{
+			if (m_generation == 0 && !m_evaluated)
+				initPopulation();
+
+			for (uint32_t genNum = 0; genNum < generationLimit; ++genNum)
+			{
+				evaluate();
+
+				if (maxWeight() >= fitnessLimit || genNum + 1 == generationLimit)
+					break;
+
+				breed();
+			}
+			return m_population;
+		};
+
+		int maxWeight() const { return m_evaluated ? m_weights[m_order[0]] : 0; };
+
+		// best genome of the last evaluation
+		const genome_type& best() const
+		{
+			if (!m_evaluated)
+				throw std::runtime_error("StaticEvolution::best error: population is not evaluated");
+			return m_population[m_order[0]];
+		};
+
+	private:
+		size_t select()
+		{
+			const uint64_t total = m_prefix[PopulationSize - 1];
+			if (total == 0)
+				return m_rng.uniform(PopulationSize);
+
+			const uint64_t r = m_rng.uniform(total);
+			return static_cast<size_t>(std::upper_bound(m_prefix.begin(), m_prefix.end(), r) - m_prefix.begin());
+		};
+
+		Fitness m_fitness;
+		StaticEvolutionConfig m_config;
+		Rng m_rng;
+		population_type m_population{};
+		population_type m_next{};
+		genome_type m_spare{}; // second offspring of the last pair when the slots left are odd
+		weights_type m_weights{};
+		std::array<uint32_t, PopulationSize> m_order{};
+		std::array<uint64_t, PopulationSize> m_prefix{};
+		bool m_evaluated{false};
+		uint64_t m_generation{0};
+	};
+
+	// deduces the fitness type: auto evolution = makeStaticEvolution<128, 64>([](const auto& genome) { ... });
+	template<size_t Bits, size_t PopulationSize, typename Fitness>
+	StaticEvolution<Bits, PopulationSize, Fitness> makeStaticEvolution(Fitness fitness, const StaticEvolutionConfig& config = {})
+	{
+		return StaticEvolution<Bits, PopulationSize, Fitness>(std::move(fitness), config);
+	}
+
+	// engine for melodies of the default length and population size
+	template<typename Fitness>
+	using MelodyEvolution = StaticEvolution<GENOME_LENGTH, GENOMES_IN_POPULATION, Fitness>;
+}
+#endif // !OMEGA_STATIC_EVOLUTION
@@ -0,0 +1,156 @@
+#ifndef OMEGA_TELEMETRY
+#define OMEGA_TELEMETRY
+
+#include "algorithm/genetic.h"
+#include "utility/seqlock.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <type_traits>
+
+namespace GeneticAlgorithm
+{
+	enum class Stage
+	{
+		INIT,
+		EVALUATE,
+		SELECT,
+		CROSSOVER,
+		MUTATE,
+		ENCODE, // MIDI encoding, reported by AuditionPipeline
+		COUNT
+	};
+
+	constexpr size_t STAGE_COUNT = static_cast<size_t>(Stage::COUNT);
+
+	const char* stageName(Stage stage);
+
+	struct GenerationStats
+	{
+		uint64_t generation{0};
+		// nanoseconds spent in every stage since the previous generation was published:
+		// the breeding that produced this generation and its evaluation
+		std::array<uint64_t, STAGE_COUNT> stageNanos{};
+		uint64_t evaluations{0}; // fitness function calls, cache hits are not counted
+		double evaluationsPerSec{0.0};
+		int bestFitness{0};
+		int worstFitness{0};
+		double meanFitness{0.0};
+		// mean Hamming distance between two genomes over the genome length:
+		// about 0.5 for random genomes, 0 once the population has converged
+		double diversity{0.0};
+		uint64_t totalEvaluations{0};
+		uint64_t totalNanos{0}; // all stages since the telemetry was created
+	};
+
+	// Per-generation metrics of an Evolution, see Evolution::setTelemetry().
+	// Stage times may be added from any thread; the evolution publishes a GenerationStats after every evaluation,
+	// hands it to the callback on its own thread and stores it where snapshot() reads it from any thread without locking.
+	// One Telemetry serves one Evolution.
+	class Telemetry
+	{
+	public:
+		using Clock	   = std::chrono::steady_clock;
+		using Callback = std::function<void(const GenerationStats&)>;
+		// stage times are clock ticks taken as nanoseconds
+		static_assert(std::is_same_v<Clock::period, std::nano>, "Telemetry needs a nanosecond clock");
+
+		// diversitySamples: genome pairs compared per generation, all pairs when the population has fewer
+		explicit Telemetry(Callback callback = {}, size_t diversitySamples = 64);
+
+		Telemetry(const Telemetry&) = delete;
+		Telemetry& operator=(const Telemetry&) = delete;
+
+		void add(Stage stage, uint64_t nanos) { m_pending[static_cast<size_t>(stage)].fetch_add(nanos, std::memory_order_relaxed); };
+
+		// called by the evolution once the population is evaluated
+		void publish(uint64_t generation, uint64_t evaluations, const Population& population, const WeightedPopulation& weightedPopulation);
+
+		// last published generation
+		GenerationStats snapshot() const { return m_snapshot.load(); };
+		// generations published so far
+		uint64_t published() const { return m_snapshot.version() - 1; };
+
+		// estimate of GenerationStats::diversity from `samples` random pairs, exact when there are fewer pairs
+		static double diversity(const Population& population, size_t samples, Rng& rng);
+
+	private:
+		Callback m_callback;
+		size_t m_diversitySamples;
+		Rng m_rng; // own generator, so telemetry never changes the course of the evolution
+
+		std::array<std::atomic<uint64_t>, STAGE_COUNT> m_pending{};
+		uint64_t m_totalEvaluations{0};
+		uint64_t m_totalNanos{0};
+		utility::SeqLock<GenerationStats> m_snapshot;
+	};
+
+	// Adds the time until its destruction to a stage; does nothing without telemetry.
+	class StageTimer
+	{
+	public:
+		StageTimer(Telemetry* telemetry, Stage stage) : m_telemetry(telemetry), m_stage(stage)
+		{
+			if (m_telemetry)
+				m_start = Telemetry::Clock::now();
+		}
+
+		~StageTimer()
+		{
+			if (m_telemetry)
+				m_telemetry->add(m_stage, static_cast<uint64_t>((Telemetry::Clock::now() - m_start).count()));
+		}
+
+		StageTimer(const StageTimer&) = delete;
+		StageTimer& operator=(const StageTimer&) = delete;
+
+	private:
+		Telemetry* m_telemetry;
+		Stage m_stage;
+		Telemetry::Clock::time_point m_start;
+	};
+
+	// Splits a stretch of interleaved work between stages, one clock read per lap: lap(stage) charges the time
+	// since the previous lap to `stage`. The sums are added on destruction; does nothing without telemetry.
+	class StageLaps
+	{
+	public:
+		explicit StageLaps(Telemetry* telemetry) : m_telemetry(telemetry)
+		{
+			if (m_telemetry)
+				m_last = Telemetry::Clock::now();
+		}
+
+		~StageLaps()
+		{
+			if (!m_telemetry)
+				return;
+
+			for (size_t i = 0; i < STAGE_COUNT; ++i)
+			{
+				if (m_nanos[i] != 0)
+					m_telemetry->add(static_cast<Stage>(i), m_nanos[i]);
+			}
+		}
+
+		StageLaps(const StageLaps&) = delete;
+		StageLaps& operator=(const StageLaps&) = delete;
+
+		void lap(Stage stage)
+		{
+			if (!m_telemetry)
+				return;
+
+			const auto now = Telemetry::Clock::now();
+			m_nanos[static_cast<size_t>(stage)] += static_cast<uint64_t>((now - m_last).count());
+			m_last = now;
+		};
+
+	private:
+		Telemetry* m_telemetry;
+		Telemetry::Clock::time_point m_last;
+		std::array<uint64_t, STAGE_COUNT> m_nanos{};
+	};
+}
+#endif // !OMEGA_TELEMETRY
@@ -0,0 +1,65 @@
+#ifndef OMEGA_AUDITION
+#define OMEGA_AUDITION
+
+#include "algorithm/genetic.h"
+#include "algorithm/telemetry.h"
+#include "utility/blocking_queue.h"
+#include "midi.h"
+#include "speaker.h"
+#include <atomic>
+#include <functional>
+
+// Human-in-the-loop evaluation.
+// While the listener rates melody i, a background thread already encodes melody i + 1 in memory and loads it
+// into the mixer, so the next audition starts as soon as the rating arrives.
+// Ratings come back through submitRating(), which may be called from any thread.
+class AuditionPipeline
+{
+public:
+	// called on the evaluating thread when genome `index` of the current batch starts playing
+	using PlayCallback = std::function<void(size_t index)>;
+
+	// lookahead is the number of melodies prepared ahead of the one playing
+	AuditionPipeline(Speaker& speaker, const MidiEncoder& encoder, PlayCallback onPlay, size_t lookahead = 1);
+
+	// Plays every genome and stores the rating of genomes[i] in weights[i].
+	// Auditions cannot overlap, so pass fitnessFunc() to the pool-less Evolution::evaluate/run overloads.
+	void evaluate(utility::Span<const GeneticAlgorithm::Genome> genomes, utility::Span<int> weights);
+	GeneticAlgorithm::BatchFitnessFunc fitnessFunc();
+
+	// rating of genome `index` of the batch being evaluated
+	void submitRating(size_t index, int weight);
+
+	// Stops the auditions for good, e.g. when the listener quits; may be called from any thread.
+	// A waiting evaluate() frees what it loaded, joins its encoder thread and throws, and so does every later call.
+	void cancel();
+
+	// charges MIDI encoding to Stage::ENCODE, usually the telemetry of the evolution being rated; nullptr turns it off
+	void setTelemetry(GeneticAlgorithm::Telemetry* telemetry) { m_telemetry = telemetry; };
+
+private:
+	struct Prepared
+	{
+		size_t index;
+		Mix_Music* music;
+	};
+
+	struct Rating
+	{
+		size_t index;
+		int weight;
+	};
+
+	void prepare(utility::Span<const GeneticAlgorithm::Genome> genomes);
+
+	Speaker& m_speaker;
+	MidiEncoder m_encoder;
+	PlayCallback m_onPlay;
+	GeneticAlgorithm::Telemetry* m_telemetry{nullptr};
+	utility::BlockingQueue<Prepared> m_prepared;
+	utility::BlockingQueue<Rating> m_ratings;
+	std::exception_ptr m_prepareError;
+	std::atomic<bool> m_cancelled{false};
+};
+
+#endif // !OMEGA_AUDITION
@@ -3,35 +3,63 @@
 
 // https://intuitive-theory.com/midi-from-scratch/
 
-#include <fstream>
+#include <array>
+#include <string>
 #include <vector>
 #include "algorithm/genetic.h"
 #include "scale.h"
 
+namespace utility
+{
+	class ThreadPool;
+}
+
+// Encodes genomes as standard MIDI files (format 1, 96 ticks per quarter).
+// Every note of a genome lasts a quarter: codes 0001 - 1110 start a scale degree,
+// 0000 is a rest and 1111 holds whatever sounds (or rests) before it one quarter longer.
+// The notes are read from Genome::noteEvents(), so a genome is decoded once however often it is encoded.
+// Track 0 carries tempo and time signature, the melodies follow as tracks 1..N.
 class MidiEncoder
 {
 public:
+	using Bytes = std::vector<unsigned char>;
+
+	// tempo in quarter notes per minute, at least 4
 	MidiEncoder(Scale scale, uint8_t tempo);
 
+	// single melody; the member buffer is reused, so repeated calls do not allocate
 	void encodeGenomeToMidi(const GeneticAlgorithm::Genome& genome, const std::string& path);
-	void writeGenomeToMidiBytes(const GeneticAlgorithm::Genome& genome, std::vector<unsigned char>& midiBytes);
+	void encodeGenomeToMidi(const GeneticAlgorithm::Genome& genome, Bytes& midiBytes) const;
+
+	// one file per genome; the buffers in `files` keep their capacity between calls
+	void encodeGenomesToMidi(utility::Span<const GeneticAlgorithm::Genome> genomes, utility::Span<const std::string> paths);
+	void encodeGenomesToMidi(utility::Span<const GeneticAlgorithm::Genome> genomes, std::vector<Bytes>& files, utility::ThreadPool* pool = nullptr) const;
+
+	// all genomes as the tracks of one file, written with a single write
+	void encodePopulationToMidi(utility::Span<const GeneticAlgorithm::Genome> genomes, const std::string& path);
+	void encodePopulationToMidi(utility::Span<const GeneticAlgorithm::Genome> genomes, Bytes& midiBytes) const;
+
+	// appends the note events of a genome without a chunk header or end of track
+	void writeGenomeToMidiBytes(const GeneticAlgorithm::Genome& genome, Bytes& midiBytes) const;
 
 private:
-	Scale m_scale;
-	std::vector<unsigned char> m_tempoBytes; // tempo is encoded into 3 bytes
-
-	// initialize with midi header
-	std::vector<unsigned char> m_midiBytes{
-		0x4D, 0x54, 0x68, 0x64, 0x00, 0x00, 0x00, 0x06,
-		0x00, 0x01, 0x00, 0x02, 0x00, 0x60, 0x4D, 0x54,
-		0x72, 0x6B, 0x00, 0x00, 0x00, 0x13, 0x00, 0xff,
-		0x51
+	// note on / note off of a code on channel 0
+	struct NoteEvent
+	{
+		std::array<unsigned char, 3> on;
+		std::array<unsigned char, 3> off;
 	};
-};
-
-// strm.write(reinterpret_cast<const char*>(&vec[0]), vec.size()*sizeof(T));
 
+	unsigned char* writeHeader(unsigned char* out, size_t tracks) const;
+	unsigned char* writeTrack(unsigned char* out, const GeneticAlgorithm::Genome& genome, size_t track) const;
+	// note events only; the ticks after the last event are returned in trailingDelta
+	unsigned char* writeEvents(unsigned char* out, const GeneticAlgorithm::Genome& genome, unsigned char channel, uint32_t& trailingDelta) const;
 
+	Scale m_scale;
+	std::array<unsigned char, 3> m_tempoBytes; // microseconds per quarter note
+	std::array<NoteEvent, 16> m_events;		   // indexed by note code, unused for 0000 and 1111
 
+	Bytes m_midiBytes;
+};
 
-#endif // !OMEGA_MIDI
\ No newline at end of file
+#endif // !OMEGA_MIDI
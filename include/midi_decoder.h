@@ -0,0 +1,67 @@
+#ifndef OMEGA_MIDI_DECODER
+#define OMEGA_MIDI_DECODER
+
+#include <array>
+#include <string>
+#include <vector>
+#include "algorithm/genetic.h"
+#include "scale.h"
+
+namespace utility
+{
+	class ThreadPool;
+}
+
+struct MidiDecoderConfig
+{
+	// bits of every genome, a multiple of 4; 0 keeps whole tracks
+	size_t genomeLength		= GENOME_LENGTH;
+	// genome notes per quarter note, MidiEncoder writes one
+	uint32_t notesPerQuarter = 1;
+	// cut tracks longer than genomeLength into consecutive genomes instead of keeping only their start
+	bool sliceTracks		= false;
+};
+
+// Turns standard MIDI files back into genomes, the inverse of MidiEncoder.
+// Every track with notes becomes a genome (or several, see sliceTracks). Time is quantized to
+// genome notes: a note starting in a slot gets the scale degree nearest to its pitch (octaves folded
+// into the two octaves of the scale), the slots it keeps sounding get 1111 and silent slots 0000.
+// Tracks are reduced to one voice: a new note cuts the one sounding, and of notes starting in the same
+// slot the highest wins. Percussion (channel 10) is ignored.
+// Files are memory-mapped and parsed in a single pass without building an event list, so memory stays
+// bounded by the genomes produced.
+class MidiDecoder
+{
+public:
+	struct CorpusStats
+	{
+		size_t files{0};
+		size_t failed{0}; // unreadable or malformed, skipped
+		size_t genomes{0};
+	};
+
+	explicit MidiDecoder(const Scale& scale, const MidiDecoderConfig& config = {});
+
+	const MidiDecoderConfig& config() const { return m_config; };
+
+	// appends the genomes of one file, throws on malformed data
+	void decodeFile(const std::string& path, GeneticAlgorithm::Population& genomes) const;
+	void decode(const unsigned char* data, size_t size, GeneticAlgorithm::Population& genomes) const;
+
+	// Appends the genomes of all files, in the order of paths. Files are spread over the pool when given;
+	// files that fail to decode are skipped and counted.
+	CorpusStats decodeCorpus(const std::vector<std::string>& paths, GeneticAlgorithm::Population& genomes, utility::ThreadPool* pool = nullptr) const;
+
+	// scale degree code (1 - 14) nearest to a MIDI pitch
+	uint8_t noteCode(uint8_t pitch) const { return m_codes[pitch & 0x7F]; };
+
+private:
+	class TrackReader;
+
+	void decodeTrack(const unsigned char* data, size_t size, uint32_t slotTicks, GeneticAlgorithm::Population& genomes) const;
+
+	MidiDecoderConfig m_config;
+	std::array<uint8_t, 128> m_codes{};
+};
+
+#endif // !OMEGA_MIDI_DECODER
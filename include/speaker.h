@@ -2,18 +2,131 @@
 #define OMEGA_SPEAKER
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_mixer.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
+#include "utility/spsc_ring.h"
 
+class Synthesizer;
+
+namespace GeneticAlgorithm
+{
+	class Genome;
+}
+
+static constexpr int SAMPLING_FREQ	   = 44100;
+static constexpr int AUDIO_BUFFER_SIZE = 1024;
+static constexpr int MONO			   = 1;
+static constexpr int STEREO			   = 2;
+
+enum class SampleFormat
+{
+	S16, // signed 16-bit
+	F32	 // 32-bit float
+};
+
+struct AudioConfig
+{
+	int sampleRate			= SAMPLING_FREQ;
+	// frames per device callback, 128 - 256 keep the output latency at a few milliseconds
+	uint16_t bufferFrames	= AUDIO_BUFFER_SIZE;
+	SampleFormat format		= SampleFormat::S16;
+	// the mono stream is copied to every channel
+	uint8_t channels		= MONO;
+	// frames the output queue holds, rounded up to a power of two
+	size_t queueFrames		= 4096;
+};
+
+// Audio output stage: producers push 16-bit mono PCM into a lock-free single-producer/single-consumer
+// queue, and the SDL audio callback drains it into the device, converting to the configured format.
+// The callback never locks or allocates; when the queue runs dry during a stream it plays silence
+// and counts an underrun.
+//
+// Every melody the speaker loads sits in a small cache that owns it.
+// Melodies loaded with loadMidiFile/loadMidiBytes are pinned until freeMusic() releases them.
+// The ones played straight away with playMidiFile/playMidiBytes are released once more than
+// `cacheCapacity` of them are loaded, least recently used first, but never while playing.
+// Loading and releasing is thread-safe.
 class Speaker
 {
 public:
-	Speaker() {};
+	explicit Speaker(const AudioConfig& audioConfig = {}, size_t cacheCapacity = 4);
 	~Speaker();
+
+	Speaker(const Speaker&) = delete;
+	Speaker& operator=(const Speaker&) = delete;
+
+	// opens the device fed by the output queue and the SDL_mixer output for MIDI
 	void openAudioDevice();
+	const AudioConfig& audioConfig() const { return m_audioConfig; };
 	void playMidiFile(const std::string& path);
+	// plays an encoded melody from memory, without a file in between
+	void playMidiBytes(std::vector<unsigned char> midiBytes);
+
+	// loads a melody into the mixer without playing it; release it with freeMusic()
+	Mix_Music* loadMidiFile(const std::string& path);
+	// the mixer reads MIDI data while playing, so the speaker keeps midiBytes until the melody is released
+	Mix_Music* loadMidiBytes(std::vector<unsigned char> midiBytes);
+	void playMusic(Mix_Music* music);
+	void freeMusic(Mix_Music* music);
+	bool isPlaying() const;
+
+	size_t loadedCount() const;
+
+	// Producer side of the output queue, for one thread at a time; not to be mixed with playMelody().
+	// Never blocks: returns how many frames fitted.
+	size_t queueAudio(const int16_t* samples, size_t frames);
+	// ends the queued stream; what is queued still plays, but running dry no longer counts as underrun
+	void finishAudio();
+	// drops the queued frames not played yet
+	void flushAudio();
+	size_t queuedFrames() const { return m_queue.readable(); };
+	uint64_t underruns() const { return m_underruns.load(std::memory_order_relaxed); };
+
+	// Plays a melody through the built-in synthesizer, replacing whatever the output queue played.
+	// A renderer thread keeps the queue filled; the synthesizer must outlive playback, stopMelody() ends it.
+	void playMelody(Synthesizer& synth, const GeneticAlgorithm::Genome& genome);
+	void stopMelody();
 
 private:
+	struct CachedMusic
+	{
+		Mix_Music* music;
+		std::vector<unsigned char> bytes;
+		bool pinned;
+		uint64_t lastUse;
+	};
+
+	// adds a pinned melody
+	Mix_Music* cache(Mix_Music* music, std::vector<unsigned char> bytes);
+	// release unpins the melody, leaving it to the cache
+	void play(Mix_Music* music, bool release);
+	// called with m_cacheMutex held
+	void evict();
+
+	static void SDLCALL audioCallback(void* userdata, Uint8* stream, int len);
+	void renderMelody(Synthesizer& synth);
+
+	AudioConfig m_audioConfig;
 	SDL_AudioDeviceID m_audioDevice{0};
+
+	utility::SpscRing<int16_t> m_queue;
+	std::vector<int16_t> m_callbackBuffer; // for formats other than mono S16
+	std::atomic<uint64_t> m_discardUntil{0};
+	std::atomic<bool> m_streaming{false};
+	std::atomic<uint64_t> m_underruns{0};
+
+	std::thread m_renderer;
+	std::atomic<bool> m_stopRenderer{false};
+
+	size_t m_cacheCapacity;
+	std::vector<CachedMusic> m_cache;
+	Mix_Music* m_playing{nullptr};
+	uint64_t m_useClock{0};
+	mutable std::mutex m_cacheMutex;
 };
 
 
@@ -0,0 +1,87 @@
+#ifndef OMEGA_SYNTH
+#define OMEGA_SYNTH
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "algorithm/genetic.h"
+#include "scale.h"
+
+struct SynthConfig
+{
+	int sampleRate	= 44100;
+	uint8_t tempo	= 130;	  // quarter notes per minute, every note of a genome lasts a quarter
+	float attack	= 0.01f;  // seconds
+	float release	= 0.05f;  // seconds
+	float gain		= 0.25f;
+};
+
+// Additive synthesizer rendering genomes straight to 16-bit mono PCM, no MIDI backend involved.
+// Notes follow the MidiEncoder reading of the codes: 0001 - 1110 start a scale degree, 0000 rests, 1111 holds;
+// load() takes them decoded from Genome::noteEvents().
+// A voice is a bank of harmonic sine partials under a linear attack/release envelope. The voice bank is
+// kept as structure of arrays and rendered a block at a time in loops without carried dependencies,
+// which compilers turn into SIMD code. Released notes ring out while the next ones start.
+class Synthesizer
+{
+public:
+	static constexpr size_t MAX_VOICES	 = 8;
+	static constexpr size_t PARTIALS	 = 4;
+	static constexpr size_t BLOCK_FRAMES = 256;
+
+	explicit Synthesizer(const Scale& scale, const SynthConfig& config = {});
+
+	const SynthConfig& config() const { return m_config; };
+
+	// starts a melody from its beginning, silencing whatever sounded
+	void load(const GeneticAlgorithm::Genome& genome);
+	// Renders the next frames of the loaded melody and returns how many were written;
+	// fewer than asked once the melody and the release of its last note are over.
+	size_t render(int16_t* out, size_t frames);
+	bool finished() const { return m_position >= m_end; };
+
+	// length of a melody including the release of its last note
+	size_t melodyFrames(const GeneticAlgorithm::Genome& genome) const;
+
+	// offline rendering, as fast as the CPU allows
+	void renderToBuffer(const GeneticAlgorithm::Genome& genome, std::vector<int16_t>& pcm);
+	void renderToWav(const GeneticAlgorithm::Genome& genome, const std::string& path);
+	static void writeWav(const std::string& path, const int16_t* pcm, size_t frames, int sampleRate);
+
+private:
+	struct Note
+	{
+		size_t start; // frame
+		size_t end;
+		float increment; // phase advance per frame, in cycles
+	};
+
+	size_t noteFrame(size_t note) const;
+	void startVoice(float increment);
+	void releaseVoice();
+	void renderVoices(float* mix, size_t frames);
+
+	SynthConfig m_config;
+	double m_framesPerNote;
+	float m_attackSlope;
+	float m_releaseSlope;
+	std::array<float, 16> m_increments{}; // by note code
+
+	std::vector<Note> m_notes;
+	size_t m_nextNote{0};
+	size_t m_position{0};
+	size_t m_end{0};
+
+	// voice bank
+	std::array<float, MAX_VOICES> m_phase{};
+	std::array<float, MAX_VOICES> m_increment{};
+	std::array<float, MAX_VOICES> m_envelope{};
+	std::array<float, MAX_VOICES> m_slope{};
+	std::array<bool, MAX_VOICES> m_active{};
+	size_t m_gated{MAX_VOICES}; // voice of the note being held, MAX_VOICES when none
+
+	std::array<float, BLOCK_FRAMES> m_mix{};
+};
+
+#endif // !OMEGA_SYNTH
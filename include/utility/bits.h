@@ -0,0 +1,68 @@
+#ifndef OMEGA_BITS
+#define OMEGA_BITS
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace utility
+{
+	// lowest bit of every nibble
+	constexpr uint64_t NIBBLE_LOW = 0x1111111111111111ull;
+
+	inline uint32_t popcount(uint64_t x)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		return static_cast<uint32_t>(__popcnt64(x));
+#elif defined(__GNUC__) || defined(__clang__)
+		return static_cast<uint32_t>(__builtin_popcountll(x));
+#else
+		x = x - ((x >> 1) & 0x5555555555555555ull);
+		x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+		x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+		return static_cast<uint32_t>((x * 0x0101010101010101ull) >> 56);
+#endif
+	}
+
+	// index of the lowest set bit, x must not be 0
+	inline uint32_t lowestBit(uint64_t x)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long idx;
+		_BitScanForward64(&idx, x);
+		return static_cast<uint32_t>(idx);
+#elif defined(__GNUC__) || defined(__clang__)
+		return static_cast<uint32_t>(__builtin_ctzll(x));
+#else
+		return popcount((x & (~x + 1)) - 1);
+#endif
+	}
+
+	// index of the highest set bit, x must not be 0
+	inline uint32_t highestBit(uint64_t x)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long idx;
+		_BitScanReverse64(&idx, x);
+		return static_cast<uint32_t>(idx);
+#elif defined(__GNUC__) || defined(__clang__)
+		return static_cast<uint32_t>(63 - __builtin_clzll(x));
+#else
+		uint32_t idx = 0;
+		while (x >>= 1)
+			++idx;
+		return idx;
+#endif
+	}
+
+	// lowest bit of every zero nibble of x
+	inline uint64_t zeroNibbles(uint64_t x)
+	{
+		x |= x >> 1;
+		x |= x >> 2;
+		return ~x & NIBBLE_LOW;
+	}
+}
+#endif // !OMEGA_BITS
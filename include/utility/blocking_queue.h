@@ -0,0 +1,71 @@
+#ifndef OMEGA_BLOCKING_QUEUE
+#define OMEGA_BLOCKING_QUEUE
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace utility
+{
+	// Bounded multi-producer/multi-consumer queue.
+	// push() waits while the queue is full and pop() while it is empty; close() wakes everybody up,
+	// after which push() refuses new items and pop() drains what is left before returning nothing.
+	template<typename T>
+	class BlockingQueue
+	{
+	public:
+		explicit BlockingQueue(size_t capacity) : m_capacity(capacity == 0 ? 1 : capacity) {}
+
+		bool push(T item)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_notFull.wait(lock, [&] { return m_closed || m_items.size() < m_capacity; });
+			if (m_closed)
+				return false;
+
+			m_items.push_back(std::move(item));
+			m_notEmpty.notify_one();
+			return true;
+		};
+
+		std::optional<T> pop()
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_notEmpty.wait(lock, [&] { return m_closed || !m_items.empty(); });
+			if (m_items.empty())
+				return std::nullopt;
+
+			T item = std::move(m_items.front());
+			m_items.pop_front();
+			m_notFull.notify_one();
+			return item;
+		};
+
+		void close()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_closed = true;
+			m_notFull.notify_all();
+			m_notEmpty.notify_all();
+		};
+
+		// reopens a closed queue, dropping anything left in it
+		void reset()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_items.clear();
+			m_closed = false;
+		};
+
+	private:
+		size_t m_capacity;
+		std::deque<T> m_items;
+		std::mutex m_mutex;
+		std::condition_variable m_notFull;
+		std::condition_variable m_notEmpty;
+		bool m_closed{false};
+	};
+}
+#endif // !OMEGA_BLOCKING_QUEUE
@@ -2,12 +2,40 @@
 #define OMEGA_LOGGER
 
 #include <spdlog/logger.h>
+#include <chrono>
 
 namespace utility
 {
-	std::shared_ptr<spdlog::logger> setupLogger(const std::vector<spdlog::sink_ptr>&);
+	enum class LogMode
+	{
+		SYNC, // messages are formatted and written by the logging thread
+		ASYNC // messages are queued and written by background threads
+	};
+
+	// what an async logger does when its queue is full
+	enum class LogOverflow
+	{
+		BLOCK,			// wait for room, nothing is lost
+		OVERRUN_OLDEST	// drop the oldest queued message, the logging thread never waits
+	};
+
+	struct LoggerConfig
+	{
+		LogMode mode		 = LogMode::SYNC;
+		size_t queueSize	 = 8192; // async: messages queued before the overflow policy applies
+		LogOverflow overflow = LogOverflow::BLOCK;
+		size_t threads		 = 1; // async: background threads writing to the sinks
+		// sinks are flushed at this interval by a background thread and right away for warnings and errors
+		std::chrono::seconds flushInterval{5};
+	};
+
+	// Creates the "core" logger and makes it the default one; later calls return the existing logger.
+	// Per-call log sites in hot paths use SPDLOG_TRACE / SPDLOG_DEBUG, which compile to nothing below
+	// SPDLOG_ACTIVE_LEVEL (info unless the build is Debug).
+	std::shared_ptr<spdlog::logger> setupLogger(const std::vector<spdlog::sink_ptr>&, const LoggerConfig& config = {});
+	// flushes and stops the logger, waiting for an async queue to drain
 	void shutdownLogger();
 }
 
 
-#endif // !OMEGA_LOGGER
\ No newline at end of file
+#endif // !OMEGA_LOGGER
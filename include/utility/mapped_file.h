@@ -0,0 +1,41 @@
+#ifndef OMEGA_MAPPED_FILE
+#define OMEGA_MAPPED_FILE
+
+#include <cstddef>
+#include <string>
+
+namespace utility
+{
+	// how the mapping will be read, passed to the OS as a readahead hint
+	enum class FileAccess
+	{
+		SEQUENTIAL, // front to back, e.g. by a parser
+		RANDOM		// scattered lookups, readahead would only evict useful pages
+	};
+
+	// Read-only memory mapping of a whole file; pages are read in by the OS as they are touched.
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		explicit MappedFile(const std::string& path, FileAccess access = FileAccess::SEQUENTIAL);
+		~MappedFile();
+
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		// null for an empty file
+		const unsigned char* data() const { return m_data; };
+		size_t size() const { return m_size; };
+		bool empty() const { return m_size == 0; };
+
+	private:
+		void close();
+
+		const unsigned char* m_data{nullptr};
+		size_t m_size{0};
+	};
+}
+#endif // !OMEGA_MAPPED_FILE
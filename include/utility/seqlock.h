@@ -0,0 +1,74 @@
+#ifndef OMEGA_SEQLOCK
+#define OMEGA_SEQLOCK
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace utility
+{
+	// Value published by one writer thread and read by any number of threads without locks.
+	// The writer never waits: it makes the sequence odd, stores the value and makes it even again.
+	// A reader copies the value and retries if the sequence was odd or changed meanwhile.
+	// The value is kept in atomic words, so a torn copy that is retried is not a data race either.
+	template<typename T>
+	class SeqLock
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "SeqLock values are copied bytewise");
+
+	public:
+		SeqLock() { store(T{}); }
+
+		SeqLock(const SeqLock&) = delete;
+		SeqLock& operator=(const SeqLock&) = delete;
+
+		// writer thread only
+		void store(const T& value)
+		{
+			const uint64_t sequence = m_sequence.load(std::memory_order_relaxed);
+			m_sequence.store(sequence + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+
+			std::array<uint64_t, WORDS> words{};
+			std::memcpy(words.data(), &value, sizeof(T));
+			for (size_t i = 0; i < WORDS; ++i)
+				m_words[i].store(words[i], std::memory_order_relaxed);
+
+			m_sequence.store(sequence + 2, std::memory_order_release);
+		};
+
+		T load() const
+		{
+			std::array<uint64_t, WORDS> words;
+			for (;;)
+			{
+				const uint64_t before = m_sequence.load(std::memory_order_acquire);
+				if (before & 1)
+					continue;
+
+				for (size_t i = 0; i < WORDS; ++i)
+					words[i] = m_words[i].load(std::memory_order_relaxed);
+
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (m_sequence.load(std::memory_order_relaxed) == before)
+					break;
+			}
+
+			T value;
+			std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+			return value;
+		};
+
+		// number of stores so far, including the one of the constructor
+		uint64_t version() const { return m_sequence.load(std::memory_order_acquire) / 2; };
+
+	private:
+		static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+		std::atomic<uint64_t> m_sequence{0};
+		std::array<std::atomic<uint64_t>, WORDS> m_words{};
+	};
+}
+#endif // !OMEGA_SEQLOCK
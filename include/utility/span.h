@@ -0,0 +1,52 @@
+#ifndef OMEGA_SPAN
+#define OMEGA_SPAN
+
+#include <cstddef>
+#include <vector>
+#include <type_traits>
+
+namespace utility
+{
+	// non-owning view over a contiguous range (minimal stand-in for C++20 std::span)
+	template<typename T>
+	class Span
+	{
+	public:
+		using element_type = T;
+		using value_type   = std::remove_cv_t<T>;
+		using iterator	   = T*;
+
+		constexpr Span() noexcept = default;
+		constexpr Span(T* data, size_t size) noexcept : m_data(data), m_size(size) {}
+
+		template<typename U, typename Alloc, typename = std::enable_if_t<std::is_convertible_v<U (*)[], T (*)[]>>>
+		Span(std::vector<U, Alloc>& v) noexcept : m_data(v.data()), m_size(v.size())
+		{
+		}
+
+		template<typename U, typename Alloc, typename = std::enable_if_t<std::is_convertible_v<const U (*)[], T (*)[]>>>
+		Span(const std::vector<U, Alloc>& v) noexcept : m_data(v.data()), m_size(v.size())
+		{
+		}
+
+		template<typename U, typename = std::enable_if_t<std::is_convertible_v<U (*)[], T (*)[]>>>
+		constexpr Span(const Span<U>& other) noexcept : m_data(other.data()), m_size(other.size())
+		{
+		}
+
+		constexpr T* data() const noexcept { return m_data; };
+		constexpr size_t size() const noexcept { return m_size; };
+		constexpr bool empty() const noexcept { return m_size == 0; };
+
+		constexpr T& operator[](size_t idx) const { return m_data[idx]; };
+		constexpr iterator begin() const noexcept { return m_data; };
+		constexpr iterator end() const noexcept { return m_data + m_size; };
+
+		constexpr Span subspan(size_t offset, size_t count) const { return Span(m_data + offset, count); };
+
+	private:
+		T* m_data{nullptr};
+		size_t m_size{0};
+	};
+}
+#endif // !OMEGA_SPAN
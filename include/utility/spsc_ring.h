@@ -0,0 +1,94 @@
+#ifndef OMEGA_SPSC_RING
+#define OMEGA_SPSC_RING
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace utility
+{
+	// Lock-free ring buffer for one producer thread and one consumer thread.
+	// Positions count items since construction and only grow, the slot of a position being
+	// position % capacity. Each side writes only its own position, publishing it with release
+	// ordering after the items are copied, so neither side ever waits for the other.
+	template<typename T>
+	class SpscRing
+	{
+	public:
+		// capacity is rounded up to a power of two
+		explicit SpscRing(size_t capacity) : m_items(roundUp(capacity)), m_mask(m_items.size() - 1) {}
+
+		SpscRing(const SpscRing&) = delete;
+		SpscRing& operator=(const SpscRing&) = delete;
+
+		size_t capacity() const { return m_items.size(); };
+
+		// producer: copies as many items as fit and returns their count
+		size_t write(const T* items, size_t count)
+		{
+			const uint64_t head = m_head.load(std::memory_order_relaxed);
+			const uint64_t tail = m_tail.load(std::memory_order_acquire);
+			count = std::min<size_t>(count, capacity() - (head - tail));
+
+			// at most two runs, the ring wrapping around once
+			const size_t slot  = head & m_mask;
+			const size_t first = std::min(count, capacity() - slot);
+			std::copy(items, items + first, m_items.data() + slot);
+			std::copy(items + first, items + count, m_items.data());
+
+			m_head.store(head + count, std::memory_order_release);
+			return count;
+		};
+
+		// consumer: copies up to count items out and returns their count
+		size_t read(T* items, size_t count)
+		{
+			const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+			const uint64_t head = m_head.load(std::memory_order_acquire);
+			count = std::min<size_t>(count, head - tail);
+
+			const size_t slot  = tail & m_mask;
+			const size_t first = std::min(count, capacity() - slot);
+			std::copy(m_items.data() + slot, m_items.data() + slot + first, items);
+			std::copy(m_items.data(), m_items.data() + (count - first), items + first);
+
+			m_tail.store(tail + count, std::memory_order_release);
+			return count;
+		};
+
+		// consumer: drops everything written before `position`
+		void discardUntil(uint64_t position)
+		{
+			const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+			const uint64_t head = m_head.load(std::memory_order_acquire);
+			if (position > tail)
+				m_tail.store(std::min(position, head), std::memory_order_release);
+		};
+
+		// producer side: position of the next item written
+		uint64_t writePosition() const { return m_head.load(std::memory_order_relaxed); };
+
+		// approximate when called from the other side
+		size_t readable() const { return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire); };
+		size_t writable() const { return capacity() - readable(); };
+
+	private:
+		static size_t roundUp(size_t capacity)
+		{
+			size_t result = 1;
+			while (result < capacity)
+				result <<= 1;
+			return result;
+		};
+
+		std::vector<T> m_items;
+		size_t m_mask;
+
+		// on separate cache lines, so the two threads do not keep stealing each other's line
+		alignas(64) std::atomic<uint64_t> m_head{0}; // written by the producer
+		alignas(64) std::atomic<uint64_t> m_tail{0}; // written by the consumer
+	};
+}
+#endif // !OMEGA_SPSC_RING
@@ -0,0 +1,103 @@
+#ifndef OMEGA_THREAD_POOL
+#define OMEGA_THREAD_POOL
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace utility
+{
+	// Work-stealing thread pool.
+	// Every worker owns a queue: it pops its own work from the back and steals from the front of
+	// other workers' queues when it runs dry. The thread calling parallelFor takes part in the work too.
+	class ThreadPool
+	{
+	public:
+		// non-owning reference to a callable taking (begin, end); dispatching through it never allocates
+		class RangeRef
+		{
+		public:
+			RangeRef() noexcept = default;
+
+			template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, RangeRef>>>
+			RangeRef(F& body) noexcept :
+				m_body(&body), m_call([](void* b, size_t begin, size_t end) { (*static_cast<F*>(b))(begin, end); })
+			{
+			}
+
+			void operator()(size_t begin, size_t end) const { m_call(m_body, begin, end); };
+
+		private:
+			void* m_body{nullptr};
+			void (*m_call)(void*, size_t, size_t){nullptr};
+		};
+
+		// threads == 0 uses one worker per hardware thread
+		explicit ThreadPool(size_t threads = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		size_t size() const { return m_workers.size(); };
+
+		// Calls body on chunks of [0, count) of at most `grain` items and returns when all of them are done.
+		// grain == 0 picks a chunk size giving every worker several chunks to balance uneven costs.
+		// The first exception thrown by body is rethrown here.
+		template<typename F>
+		void parallelFor(size_t count, F&& body, size_t grain = 0)
+		{
+			run(count, RangeRef(body), grain);
+		}
+
+	private:
+		struct Batch
+		{
+			std::atomic<size_t> remaining{0};
+			std::mutex mutex;
+			std::condition_variable done;
+			std::exception_ptr error;
+		};
+
+		struct Task
+		{
+			RangeRef body;
+			size_t begin;
+			size_t end;
+			Batch* batch;
+		};
+
+		// ring of tasks that keeps its storage between batches
+		struct Queue
+		{
+			std::mutex mutex;
+			std::vector<Task> ring;
+			size_t head{0};
+			size_t count{0};
+
+			void pushBack(const Task& task);
+			bool popBack(Task& task);
+			bool popFront(Task& task);
+		};
+
+		void run(size_t count, RangeRef body, size_t grain);
+		bool tryRunTask(size_t self);
+		void runTask(const Task& task);
+		void workerLoop(size_t idx);
+
+		std::vector<std::unique_ptr<Queue>> m_queues;
+		std::vector<std::thread> m_workers;
+		std::atomic<size_t> m_pending{0};
+		std::atomic<size_t> m_nextQueue{0};
+		std::mutex m_sleepMutex;
+		std::condition_variable m_wake;
+		bool m_stop{false};
+	};
+}
+#endif // !OMEGA_THREAD_POOL
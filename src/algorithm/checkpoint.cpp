@@ -0,0 +1,393 @@
+#include "algorithm/checkpoint.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace GeneticAlgorithm;
+
+static_assert(sizeof(int) == 4, "weights are stored as 32-bit integers");
+
+static constexpr char g_magic[8]		   = {'O', 'M', 'G', 'C', 'K', 'P', 'T', '\0'};
+static constexpr uint32_t g_version		   = 2;
+static constexpr uint32_t g_byteOrderMark = 0x01020304;
+static constexpr uint64_t g_sectionAlign  = 64;
+
+// file layout: this header, then the sections at their offsets
+struct CheckpointHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint64_t fileSize;
+	uint64_t checksum; // of the bytes from `generation` to the end of the file
+	uint64_t generation;
+	uint64_t rngState[4];
+
+	uint64_t populationSize;
+	uint64_t genomeLength;
+	uint64_t wordsPerGenome;
+	uint64_t elites;
+	uint64_t tournamentSize;
+	uint64_t mutationCount;
+	uint64_t fitnessCacheCapacity;
+	uint64_t seed;
+	uint32_t hasSeed;
+	uint32_t selection;
+	float mutationProbability;
+	uint32_t evaluated;
+
+	uint64_t cacheEntries;
+	// sections, from the start of the file; 0 when absent
+	uint64_t genomesOffset;
+	uint64_t weightsOffset;
+	uint64_t cacheKeysOffset;
+	uint64_t cacheHashesOffset;
+	uint64_t cacheWeightsOffset;
+
+	// since version 2
+	double mutationRate;
+	uint32_t crossover;
+
+	uint8_t reserved[44];
+};
+static_assert(sizeof(CheckpointHeader) == 256, "sections start aligned right after the header");
+
+static constexpr size_t g_checksumStart = offsetof(CheckpointHeader, generation);
+
+namespace
+{
+// Multiply-rotate hash of 64-bit words in four independent lanes, so consecutive words do not wait for
+// each other's multiplication; runs at memory speed over a mapped checkpoint.
+class Checksum
+{
+public:
+	// a partial word at the end is held back until the next update completes it
+	void update(const void* data, size_t bytes)
+	{
+		const auto* in = static_cast<const unsigned char*>(data);
+		if (m_pendingBytes > 0)
+		{
+			const size_t take = std::min(bytes, sizeof(uint64_t) - m_pendingBytes);
+			std::memcpy(m_pending + m_pendingBytes, in, take);
+			m_pendingBytes += take;
+			in += take;
+			bytes -= take;
+			if (m_pendingBytes < sizeof(uint64_t))
+				return;
+			mix(load(m_pending));
+			m_pendingBytes = 0;
+		}
+
+		size_t words = bytes / sizeof(uint64_t);
+
+		for (; words > 0 && (m_count & 3) != 0; --words, in += 8)
+			mix(load(in));
+
+		for (; words >= 4; words -= 4, in += 32)
+		{
+			m_lanes[0] = round(m_lanes[0], load(in));
+			m_lanes[1] = round(m_lanes[1], load(in + 8));
+			m_lanes[2] = round(m_lanes[2], load(in + 16));
+			m_lanes[3] = round(m_lanes[3], load(in + 24));
+			m_count += 4;
+		}
+
+		for (; words > 0; --words, in += 8)
+			mix(load(in));
+
+		m_pendingBytes = bytes % sizeof(uint64_t);
+		std::memcpy(m_pending, in, m_pendingBytes);
+	};
+
+	uint64_t value() const
+	{
+		uint64_t h = m_count;
+		for (const auto lane : m_lanes)
+			h = round(h, lane);
+		h ^= h >> 33;
+		h *= 0xFF51AFD7ED558CCDull;
+		h ^= h >> 33;
+		return h;
+	};
+
+private:
+	static uint64_t load(const unsigned char* p)
+	{
+		uint64_t word;
+		std::memcpy(&word, p, sizeof(word));
+		return word;
+	};
+
+	static uint64_t round(uint64_t h, uint64_t word)
+	{
+		h ^= word * 0xBF58476D1CE4E5B9ull;
+		return (h << 31 | h >> 33) * 0x94D049BB133111EBull;
+	};
+
+	void mix(uint64_t word)
+	{
+		m_lanes[m_count & 3] = round(m_lanes[m_count & 3], word);
+		++m_count;
+	};
+
+	uint64_t m_lanes[4] = {0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull, 0x27D4EB2F165667C5ull};
+	uint64_t m_count{0};
+	unsigned char m_pending[sizeof(uint64_t)]{};
+	size_t m_pendingBytes{0};
+};
+
+// buffered writes that feed the checksum on the way
+class CheckpointWriter
+{
+public:
+	CheckpointWriter(std::FILE* file, Checksum& checksum) : m_file(file), m_checksum(checksum) {}
+
+	void write(const void* data, size_t bytes)
+	{
+		m_checksum.update(data, bytes);
+		m_ok = m_ok && std::fwrite(data, 1, bytes, m_file) == bytes;
+		m_position += bytes;
+	};
+
+	// zero padding up to `offset`
+	void padTo(uint64_t offset)
+	{
+		static const unsigned char zero[g_sectionAlign] = {};
+		while (m_position < offset)
+			write(zero, static_cast<size_t>(std::min<uint64_t>(offset - m_position, sizeof(zero))));
+	};
+
+	bool ok() const { return m_ok; };
+
+private:
+	std::FILE* m_file;
+	Checksum& m_checksum;
+	uint64_t m_position{sizeof(CheckpointHeader)};
+	bool m_ok{true};
+};
+}
+
+static uint64_t alignSection(uint64_t offset)
+{
+	return (offset + g_sectionAlign - 1) / g_sectionAlign * g_sectionAlign;
+}
+
+static bool syncFile(std::FILE* file)
+{
+	if (std::fflush(file) != 0)
+		return false;
+#ifdef _WIN32
+	return _commit(_fileno(file)) == 0;
+#else
+	return ::fsync(::fileno(file)) == 0;
+#endif
+}
+
+// makes the rename itself durable; Windows has no equivalent for directories
+static void syncDirectory(const std::filesystem::path& directory)
+{
+#ifndef _WIN32
+	const int dir = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+	if (dir >= 0)
+	{
+		::fsync(dir);
+		::close(dir);
+	}
+#else
+	(void)directory;
+#endif
+}
+
+void Checkpoint::save(const Evolution& evolution, const std::string& path)
+{
+	const EvolutionConfig& config = evolution.config();
+	const Population& population  = evolution.population();
+	const FitnessCache* cache	   = evolution.fitnessCache();
+
+	if (population.empty())
+		throw std::runtime_error("Checkpoint::save error: population is not initialized");
+
+	const uint64_t words	 = Genome::wordsForBits(config.genomeLength);
+	const bool evaluated	 = evolution.weightedPopulation().size() == population.size();
+	const uint64_t cacheSize = cache ? cache->size() : 0;
+
+	CheckpointHeader header{};
+	std::memcpy(header.magic, g_magic, sizeof(g_magic));
+	header.version				= g_version;
+	header.byteOrder			= g_byteOrderMark;
+	header.generation			= evolution.generation();
+	const auto state			= evolution.rng().state();
+	std::copy(state.begin(), state.end(), header.rngState);
+	header.populationSize		= population.size();
+	header.genomeLength			= config.genomeLength;
+	header.wordsPerGenome		= words;
+	header.elites				= config.elites;
+	header.tournamentSize		= config.tournamentSize;
+	header.mutationCount		= config.mutationCount;
+	header.fitnessCacheCapacity = config.fitnessCacheCapacity;
+	header.hasSeed				= config.seed.has_value();
+	header.seed					= config.seed.value_or(0);
+	header.selection			= static_cast<uint32_t>(config.selection);
+	header.mutationProbability	= config.mutationProbability;
+	header.mutationRate			= config.mutationRate;
+	header.crossover			= static_cast<uint32_t>(config.crossover);
+	header.evaluated			= evaluated;
+	header.cacheEntries			= cacheSize;
+
+	uint64_t offset		 = sizeof(CheckpointHeader);
+	header.genomesOffset = offset;
+	offset				 = alignSection(offset + population.size() * words * sizeof(Genome::word_t));
+	if (evaluated)
+	{
+		header.weightsOffset = offset;
+		offset				 = alignSection(offset + population.size() * sizeof(int));
+	}
+	if (cacheSize > 0)
+	{
+		header.cacheKeysOffset	  = offset;
+		offset					  = alignSection(offset + cacheSize * words * sizeof(Genome::word_t));
+		header.cacheHashesOffset  = offset;
+		offset					  = alignSection(offset + cacheSize * sizeof(uint64_t));
+		header.cacheWeightsOffset = offset;
+		offset					  = alignSection(offset + cacheSize * sizeof(int));
+	}
+	header.fileSize = offset;
+
+	const std::string tempPath = path + ".tmp";
+	std::FILE* file			   = std::fopen(tempPath.c_str(), "wb");
+	if (!file)
+		throw std::runtime_error("Checkpoint::save error: cannot create " + tempPath);
+
+	// the header goes first with a zero checksum and is rewritten once the checksum is known
+	Checksum checksum;
+	checksum.update(reinterpret_cast<const unsigned char*>(&header) + g_checksumStart, sizeof(CheckpointHeader) - g_checksumStart);
+	bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+
+	CheckpointWriter writer(file, checksum);
+	for (const auto& genome : population)
+	{
+		if (genome.wordCount() != words)
+		{
+			std::fclose(file);
+			std::remove(tempPath.c_str());
+			throw std::runtime_error("Checkpoint::save error: genome length differs from the config");
+		}
+		writer.write(genome.data(), words * sizeof(Genome::word_t));
+	}
+
+	if (evaluated)
+	{
+		std::vector<int> weights(population.size());
+		for (const auto& [idx, weight] : evolution.weightedPopulation())
+			weights[idx] = weight;
+
+		writer.padTo(header.weightsOffset);
+		writer.write(weights.data(), weights.size() * sizeof(int));
+	}
+
+	if (cacheSize > 0)
+	{
+		writer.padTo(header.cacheKeysOffset);
+		writer.write(cache->keyData(), cacheSize * words * sizeof(Genome::word_t));
+		writer.padTo(header.cacheHashesOffset);
+		writer.write(cache->hashData(), cacheSize * sizeof(uint64_t));
+		writer.padTo(header.cacheWeightsOffset);
+		writer.write(cache->weightData(), cacheSize * sizeof(int));
+	}
+	writer.padTo(header.fileSize);
+
+	header.checksum = checksum.value();
+	ok				= ok && writer.ok() && std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, file) == 1;
+	ok				= syncFile(file) && ok;
+	ok				= std::fclose(file) == 0 && ok;
+	if (!ok)
+	{
+		std::remove(tempPath.c_str());
+		throw std::runtime_error("Checkpoint::save error: cannot write " + tempPath);
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, path, error);
+	if (error)
+	{
+		std::remove(tempPath.c_str());
+		throw std::runtime_error("Checkpoint::save error: cannot replace " + path + ": " + error.message());
+	}
+	syncDirectory(std::filesystem::path(path).parent_path());
+}
+
+Checkpoint::Checkpoint(const std::string& path, bool verify) : m_file(path)
+{
+	if (m_file.size() < sizeof(CheckpointHeader))
+		throw std::runtime_error("Checkpoint error: " + path + " is not a checkpoint");
+
+	// the mapping is page aligned
+	const auto& h = *reinterpret_cast<const CheckpointHeader*>(m_file.data());
+	if (std::memcmp(h.magic, g_magic, sizeof(g_magic)) != 0 || h.version != g_version)
+		throw std::runtime_error("Checkpoint error: " + path + " is not a checkpoint");
+
+	if (h.byteOrder != g_byteOrderMark)
+		throw std::runtime_error("Checkpoint error: " + path + " was written with another byte order");
+
+	if (h.fileSize != m_file.size())
+		throw std::runtime_error("Checkpoint error: " + path + " is truncated");
+
+	if (h.wordsPerGenome != Genome::wordsForBits(h.genomeLength) || h.selection > static_cast<uint32_t>(SelectionStrategy::TOURNAMENT) ||
+		h.crossover > static_cast<uint32_t>(CrossoverType::BAR_ALIGNED))
+		throw std::runtime_error("Checkpoint error: " + path + " has an invalid header");
+
+	// every section must lie inside the file
+	const auto section = [&](uint64_t offset, uint64_t count, uint64_t itemSize) -> const unsigned char* {
+		if (offset % sizeof(uint64_t) != 0 || offset < sizeof(CheckpointHeader) || offset > h.fileSize ||
+			(itemSize != 0 && count > (h.fileSize - offset) / itemSize))
+			throw std::runtime_error("Checkpoint error: " + path + " has an invalid section");
+		return m_file.data() + offset;
+	};
+
+	const uint64_t genomeBytes = h.wordsPerGenome * sizeof(Genome::word_t);
+	m_genomes = reinterpret_cast<const Genome::word_t*>(section(h.genomesOffset, h.populationSize, genomeBytes));
+	if (h.evaluated)
+		m_weights = reinterpret_cast<const int*>(section(h.weightsOffset, h.populationSize, sizeof(int)));
+
+	if (h.cacheEntries > 0)
+	{
+		m_cacheEntries = static_cast<size_t>(h.cacheEntries);
+		m_cacheKeys	   = reinterpret_cast<const Genome::word_t*>(section(h.cacheKeysOffset, h.cacheEntries, genomeBytes));
+		m_cacheHashes  = reinterpret_cast<const uint64_t*>(section(h.cacheHashesOffset, h.cacheEntries, sizeof(uint64_t)));
+		m_cacheWeights = reinterpret_cast<const int*>(section(h.cacheWeightsOffset, h.cacheEntries, sizeof(int)));
+	}
+
+	if (verify)
+	{
+		Checksum checksum;
+		checksum.update(m_file.data() + g_checksumStart, m_file.size() - g_checksumStart);
+		if (checksum.value() != h.checksum)
+			throw std::runtime_error("Checkpoint error: " + path + " is corrupted, checksum mismatch");
+	}
+
+	m_config.populationSize		  = static_cast<size_t>(h.populationSize);
+	m_config.genomeLength		  = static_cast<size_t>(h.genomeLength);
+	m_config.seed				  = h.hasSeed ? std::optional<uint64_t>(h.seed) : std::nullopt;
+	m_config.elites				  = static_cast<size_t>(h.elites);
+	m_config.selection			  = static_cast<SelectionStrategy>(h.selection);
+	m_config.tournamentSize		  = static_cast<size_t>(h.tournamentSize);
+	m_config.mutationCount		  = static_cast<size_t>(h.mutationCount);
+	m_config.mutationProbability  = h.mutationProbability;
+	m_config.crossover			  = static_cast<CrossoverType>(h.crossover);
+	m_config.mutationRate		  = h.mutationRate;
+	m_config.fitnessCacheCapacity = static_cast<size_t>(h.fitnessCacheCapacity);
+
+	m_generation = h.generation;
+	std::copy(std::begin(h.rngState), std::end(h.rngState), m_rngState.begin());
+}
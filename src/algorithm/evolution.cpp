@@ -0,0 +1,471 @@
+#include "algorithm/evolution.h"
+#include "algorithm/checkpoint.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace GeneticAlgorithm;
+
+// changed note runs passed to IncrementalFitness::update, the last one covers any further ones
+static constexpr size_t g_maxChangedRanges = 8;
+
+static uint64_t resolveSeed(const EvolutionConfig& config)
+{
+	return config.seed ? *config.seed : Random::threadRng()();
+}
+
+Evolution::Evolution(const EvolutionConfig& config) :
+	m_config(config), m_rng(resolveSeed(config)), m_selector(config.selection, config.tournamentSize)
+{
+	if (m_config.populationSize < 2)
+		throw std::runtime_error("Evolution error: population must contain at least 2 genomes");
+
+	if (m_config.elites > m_config.populationSize)
+		throw std::runtime_error("Evolution error: more elites than genomes in population");
+
+	m_population.reserve(m_config.populationSize);
+	m_weightedPopulation.reserve(m_config.populationSize);
+
+	if (m_config.fitnessCacheCapacity > 0)
+		m_cache = std::make_unique<FitnessCache>(m_config.fitnessCacheCapacity, m_config.genomeLength);
+}
+
+void Evolution::initPopulation()
+{
+	StageTimer timer(m_telemetry, Stage::INIT);
+	m_population	 = Genetic::generatePopulation(m_config.populationSize, m_config.genomeLength, m_rng);
+	m_nextPopulation = Population(m_config.populationSize, Genome(m_config.genomeLength));
+	m_spare			 = Genome(m_config.genomeLength);
+	m_weightedPopulation.clear();
+	m_generation   = 0;
+	m_stateFitness = nullptr;
+}
+
+void Evolution::evaluate(const FitnessFunc& fitnessFunc)
+{
+	{
+		StageTimer timer(m_telemetry, Stage::EVALUATE);
+		m_evaluations = m_population.size();
+
+		if (m_cache)
+			evaluateCached(fitnessFunc);
+		else
+			Genetic::generateWeightedDistribution(m_population, fitnessFunc, m_weightedPopulation);
+	}
+	finishEvaluation();
+}
+
+void Evolution::evaluate(const BatchFitnessFunc& fitnessFunc, utility::ThreadPool& pool)
+{
+	{
+		StageTimer timer(m_telemetry, Stage::EVALUATE);
+		m_evaluations = m_population.size();
+
+		if (m_cache)
+			evaluateCached(fitnessFunc, &pool);
+		else
+		{
+			Genetic::evaluatePopulation(m_population, fitnessFunc, pool, m_weights);
+			Genetic::weightPopulation(m_weights, m_weightedPopulation);
+		}
+	}
+	finishEvaluation();
+}
+
+void Evolution::evaluate(const BatchFitnessFunc& fitnessFunc)
+{
+	{
+		StageTimer timer(m_telemetry, Stage::EVALUATE);
+		m_evaluations = m_population.size();
+
+		if (m_cache)
+			evaluateCached(fitnessFunc, nullptr);
+		else
+		{
+			m_weights.resize(m_population.size());
+			fitnessFunc(utility::Span<const Genome>(m_population), utility::Span<int>(m_weights));
+			Genetic::weightPopulation(m_weights, m_weightedPopulation);
+		}
+	}
+	finishEvaluation();
+}
+
+void Evolution::evaluate(const IncrementalFitness& fitness)
+{
+	{
+		StageTimer timer(m_telemetry, Stage::EVALUATE);
+		evaluateIncremental(fitness, nullptr);
+	}
+	finishEvaluation();
+	m_stateFitness = &fitness;
+}
+
+void Evolution::evaluate(const IncrementalFitness& fitness, utility::ThreadPool& pool)
+{
+	{
+		StageTimer timer(m_telemetry, Stage::EVALUATE);
+		evaluateIncremental(fitness, &pool);
+	}
+	finishEvaluation();
+	m_stateFitness = &fitness;
+}
+
+void Evolution::finishEvaluation()
+{
+	m_resumedEvaluated = false;
+	m_stateFitness	   = nullptr;
+	if (m_telemetry)
+		m_telemetry->publish(m_generation, m_evaluations, m_population, m_weightedPopulation);
+}
+
+void Evolution::evaluateCached(const FitnessFunc& fitnessFunc)
+{
+	m_weights.resize(m_population.size());
+	m_evaluations = 0;
+
+	// a duplicate within the generation hits the entry its first copy just inserted
+	for (size_t i = 0; i < m_population.size(); ++i)
+	{
+		const Genome& genome = m_population[i];
+		const uint64_t hash	 = genome.hash();
+
+		if (auto weight = m_cache->find(genome, hash))
+		{
+			m_weights[i] = *weight;
+			continue;
+		}
+
+		m_weights[i] = fitnessFunc(genome);
+		++m_evaluations;
+		m_cache->insert(genome, hash, m_weights[i]);
+	}
+
+	Genetic::weightPopulation(m_weights, m_weightedPopulation);
+}
+
+void Evolution::evaluateCached(const BatchFitnessFunc& fitnessFunc, utility::ThreadPool* pool)
+{
+	const size_t size = m_population.size();
+	m_weights.resize(size);
+	m_hashes.resize(size);
+	m_misses.clear();
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		m_hashes[i] = m_population[i].hash();
+		if (auto weight = m_cache->find(m_population[i], m_hashes[i]))
+			m_weights[i] = *weight;
+		else
+			m_misses.push_back(static_cast<uint32_t>(i));
+	}
+
+	// group misses by hash so duplicates within the generation are scored only once
+	std::sort(m_misses.begin(), m_misses.end(), [&](uint32_t a, uint32_t b) {
+		return m_hashes[a] != m_hashes[b] ? m_hashes[a] < m_hashes[b] : a < b;
+	});
+
+	m_missSource.resize(m_misses.size());
+	m_missCount		 = 0;
+	size_t runStart	 = 0; // first distinct genome with the current hash
+	for (size_t k = 0; k < m_misses.size(); ++k)
+	{
+		const Genome& genome = m_population[m_misses[k]];
+		if (k == 0 || m_hashes[m_misses[k]] != m_hashes[m_misses[k - 1]])
+			runStart = m_missCount;
+
+		size_t source = runStart;
+		while (source < m_missCount && m_missGenomes[source] != genome)
+			++source;
+
+		if (source == m_missCount)
+		{
+			if (m_missGenomes.size() == m_missCount)
+				m_missGenomes.emplace_back(genome);
+			else
+				m_missGenomes[m_missCount] = genome;
+			++m_missCount;
+		}
+		m_missSource[k] = static_cast<uint32_t>(source);
+	}
+
+	m_missWeights.resize(m_missCount);
+	m_evaluations = m_missCount;
+	const utility::Span<const Genome> missed(m_missGenomes.data(), m_missCount);
+	if (pool)
+		Genetic::evaluatePopulation(missed, fitnessFunc, *pool, utility::Span<int>(m_missWeights), 0);
+	else if (m_missCount > 0)
+		fitnessFunc(missed, utility::Span<int>(m_missWeights));
+
+	for (size_t k = 0; k < m_misses.size(); ++k)
+	{
+		const uint32_t idx = m_misses[k];
+		m_weights[idx]	   = m_missWeights[m_missSource[k]];
+		m_cache->insert(m_population[idx], m_hashes[idx], m_weights[idx]);
+	}
+
+	Genetic::weightPopulation(m_weights, m_weightedPopulation);
+}
+
+static size_t changedCount(const std::array<NoteRange, g_maxChangedRanges>& ranges, size_t count)
+{
+	size_t notes = 0;
+	for (size_t i = 0; i < count; ++i)
+		notes += ranges[i].last - ranges[i].first;
+	return notes;
+}
+
+void Evolution::evaluateIncremental(const IncrementalFitness& fitness, utility::ThreadPool* pool)
+{
+	const size_t size	= m_population.size();
+	const size_t stride = (fitness.stateSize() + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+	// summaries of the parents, in m_nextPopulation since breed(), are usable when this fitness wrote them
+	const bool incremental = m_stateFitness == &fitness && m_stateStride == stride && m_lineage.size() == size &&
+							 m_nextPopulation.size() * stride == m_states.size();
+
+	std::swap(m_states, m_parentStates);
+	std::swap(m_stateHashes, m_parentHashes);
+	m_states.resize(size * stride);
+	m_stateHashes.resize(size);
+	m_stateStride = stride;
+	m_weights.resize(size);
+	m_evaluations = size;
+
+	// a parent changed through population() after its evaluation no longer matches its summary
+	m_parentValid.resize(m_nextPopulation.size());
+	auto checkParents = [&](size_t begin, size_t end) {
+		for (size_t j = begin; j < end; ++j)
+			m_parentValid[j] = incremental && m_nextPopulation[j].hash() == m_parentHashes[j];
+	};
+
+	auto score = [&](size_t begin, size_t end) {
+		std::array<NoteRange, g_maxChangedRanges> ranges;
+		std::array<NoteRange, g_maxChangedRanges> otherRanges;
+
+		for (size_t i = begin; i < end; ++i)
+		{
+			const Genome& genome = m_population[i];
+			uint64_t* state		 = m_states.data() + i * stride;
+			m_stateHashes[i]	 = genome.hash();
+
+			auto [base, other] = incremental ? m_lineage[i] : std::pair<uint32_t, uint32_t>{0, 0};
+			if (!incremental || !m_parentValid[base] || !m_parentValid[other])
+			{
+				m_weights[i] = fitness.evaluate(genome, state);
+				continue;
+			}
+
+			// offspring are scored from the parent they differ from in fewer notes
+			size_t count = Genetic::changedNotes(m_nextPopulation[base], genome, utility::Span<NoteRange>(ranges.data(), ranges.size()));
+			if (count > 0 && other != base)
+			{
+				const size_t otherCount = Genetic::changedNotes(m_nextPopulation[other], genome, utility::Span<NoteRange>(otherRanges.data(), otherRanges.size()));
+				if (changedCount(otherRanges, otherCount) < changedCount(ranges, count))
+				{
+					base   = other;
+					count  = otherCount;
+					ranges = otherRanges;
+				}
+			}
+
+			m_weights[i] = fitness.update(m_nextPopulation[base], m_parentStates.data() + base * stride, genome,
+										  utility::Span<const NoteRange>(ranges.data(), count), state);
+		}
+	};
+
+	if (pool)
+	{
+		pool->parallelFor(m_nextPopulation.size(), checkParents);
+		pool->parallelFor(size, score);
+	}
+	else
+	{
+		checkParents(0, m_nextPopulation.size());
+		score(0, size);
+	}
+
+	// the lineage belongs to this population only, evaluating it again starts over
+	m_lineage.clear();
+	Genetic::weightPopulation(m_weights, m_weightedPopulation);
+}
+
+void Evolution::breed()
+{
+	if (m_weightedPopulation.size() != m_population.size())
+		throw std::runtime_error("Evolution::breed error: population must be evaluated first");
+
+	if (m_nextPopulation.size() != m_population.size())
+		m_nextPopulation.resize(m_population.size(), Genome(m_config.genomeLength));
+
+	const size_t size = m_population.size();
+	size_t slot		  = 0;
+	StageLaps laps(m_telemetry);
+
+	m_lineage.resize(size);
+
+	// weighted population is in ascending order, the elites are at its end
+	for (; slot < m_config.elites; ++slot)
+	{
+		const uint32_t elite	= m_weightedPopulation[size - 1 - slot].first;
+		m_nextPopulation[slot] = m_population[elite];
+		m_lineage[slot]		   = {elite, elite};
+	}
+
+	m_selector.prepare(m_weightedPopulation);
+	m_selector.selectPairs((size - slot + 1) / 2, m_rng, m_parents);
+	laps.lap(Stage::SELECT);
+
+	for (size_t pair = 0; slot < size; slot += 2, ++pair)
+	{
+		const auto [first, second] = m_parents[pair];
+
+		Genome& offspringA = m_nextPopulation[slot];
+		Genome& offspringB = slot + 1 < size ? m_nextPopulation[slot + 1] : m_spare;
+		m_lineage[slot]	   = m_parents[pair];
+		if (slot + 1 < size)
+			m_lineage[slot + 1] = m_lineage[slot];
+
+		Genetic::crossover(m_config.crossover, m_population[first], m_population[second], offspringA, offspringB, m_rng);
+		laps.lap(Stage::CROSSOVER);
+
+		if (m_config.mutationRate <= 0)
+		{
+			Genetic::mutation(offspringA, m_config.mutationCount, m_config.mutationProbability, m_rng);
+			Genetic::mutation(offspringB, m_config.mutationCount, m_config.mutationProbability, m_rng);
+			laps.lap(Stage::MUTATE);
+		}
+	}
+
+	// flips are drawn over all offspring at once, the elites stay unchanged
+	if (m_config.mutationRate > 0)
+	{
+		const utility::Span<Genome> offspring(m_nextPopulation.data() + m_config.elites, size - m_config.elites);
+		Genetic::flipMutation(offspring, m_config.mutationRate, m_rng);
+		laps.lap(Stage::MUTATE);
+	}
+
+	std::swap(m_population, m_nextPopulation);
+	m_weightedPopulation.clear();
+	m_resumedEvaluated = false;
+	++m_generation;
+}
+
+void Evolution::setCheckpoint(std::string path, uint32_t interval)
+{
+	m_checkpointPath	 = std::move(path);
+	m_checkpointInterval = interval;
+}
+
+void Evolution::saveCheckpoint()
+{
+	if (m_checkpointInterval != 0 && (m_generation + 1) % m_checkpointInterval == 0)
+		Checkpoint::save(*this, m_checkpointPath);
+}
+
+void Evolution::resume(const Checkpoint& checkpoint)
+{
+	if (checkpoint.populationSize() != m_config.populationSize || checkpoint.genomeLength() != m_config.genomeLength)
+		throw std::runtime_error("Evolution::resume error: checkpoint population differs from the config");
+
+	const size_t size = checkpoint.populationSize();
+
+	// genomes already of the right length are overwritten in place; the spare population is sized by breed()
+	m_population.resize(size);
+	for (size_t i = 0; i < size; ++i)
+		m_population[i].assign(checkpoint.genome(i));
+
+	if (m_spare.size() != m_config.genomeLength)
+		m_spare = Genome(m_config.genomeLength);
+	m_rng.setState(checkpoint.rngState());
+	m_generation   = checkpoint.generation();
+	m_stateFitness = nullptr;
+
+	m_weightedPopulation.clear();
+	m_resumedEvaluated = checkpoint.weights() != nullptr;
+	if (m_resumedEvaluated)
+	{
+		m_weights.assign(checkpoint.weights(), checkpoint.weights() + size);
+		Genetic::weightPopulation(m_weights, m_weightedPopulation);
+	}
+
+	if (m_cache)
+		m_cache->restore(checkpoint.cacheKeys(), checkpoint.cacheHashes(), checkpoint.cacheWeights(), checkpoint.cacheEntries());
+}
+
+template<typename EvaluateFunc>
+const Population& Evolution::runLoop(EvaluateFunc&& evaluateFunc, int fitnessLimit, uint32_t generationLimit)
+{
+	if (m_population.empty())
+		initPopulation();
+
+	for (uint32_t genNum = 0; genNum < generationLimit; ++genNum)
+	{
+		// a resumed population may come with its weights
+		if (!m_resumedEvaluated)
+		{
+			evaluateFunc();
+			saveCheckpoint();
+		}
+
+		if (maxWeight() >= fitnessLimit || genNum + 1 == generationLimit)
+			break;
+
+		breed();
+	}
+	spdlog::info("Evolution is finished");
+
+	return m_population;
+}
+
+const Population& Evolution::run(const FitnessFunc& fitnessFunc, int fitnessLimit, uint32_t generationLimit)
+{
+	return runLoop([&] { evaluate(fitnessFunc); }, fitnessLimit, generationLimit);
+}
+
+const Population& Evolution::run(const BatchFitnessFunc& fitnessFunc, utility::ThreadPool& pool, int fitnessLimit, uint32_t generationLimit)
+{
+	return runLoop([&] { evaluate(fitnessFunc, pool); }, fitnessLimit, generationLimit);
+}
+
+const Population& Evolution::run(const BatchFitnessFunc& fitnessFunc, int fitnessLimit, uint32_t generationLimit)
+{
+	return runLoop([&] { evaluate(fitnessFunc); }, fitnessLimit, generationLimit);
+}
+
+const Population& Evolution::run(const IncrementalFitness& fitness, int fitnessLimit, uint32_t generationLimit)
+{
+	return runLoop([&] { evaluate(fitness); }, fitnessLimit, generationLimit);
+}
+
+const Population& Evolution::run(const IncrementalFitness& fitness, utility::ThreadPool& pool, int fitnessLimit, uint32_t generationLimit)
+{
+	return runLoop([&] { evaluate(fitness, pool); }, fitnessLimit, generationLimit);
+}
+
+Population Evolution::sortedPopulation(bool reversed) const
+{
+	return Genetic::sortPopulation(m_population, m_weightedPopulation, reversed);
+}
+
+void Evolution::sortedPopulation(std::vector<GenomeView>& sorted, bool reversed) const
+{
+	Genetic::sortPopulation(m_population, m_weightedPopulation, sorted, reversed);
+}
+
+std::tuple<GenomeView, GenomeView> Evolution::selectionPair()
+{
+	return Genetic::selectionPair(m_population, m_weightedPopulation, m_rng);
+}
+
+int Evolution::maxWeight() const
+{
+	return m_weightedPopulation.empty() ? 0 : m_weightedPopulation.back().second;
+}
+
+const Genome& Evolution::best() const
+{
+	if (m_weightedPopulation.empty())
+		throw std::runtime_error("Evolution::best error: population is not evaluated");
+
+	return m_population[m_weightedPopulation.back().first];
+}
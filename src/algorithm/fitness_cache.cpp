@@ -0,0 +1,164 @@
+#include "algorithm/fitness_cache.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace GeneticAlgorithm;
+
+static size_t indexSizeFor(size_t capacity)
+{
+	// keep the load factor at or below 1/2
+	size_t size = 16;
+	while (size < capacity * 2)
+		size <<= 1;
+	return size;
+}
+
+FitnessCache::FitnessCache(size_t capacity, size_t genomeLength) :
+	m_genomeLength(genomeLength),
+	m_words(Genome::wordsForBits(genomeLength)),
+	m_keys(capacity * m_words),
+	m_hashes(capacity),
+	m_weights(capacity),
+	m_referenced(capacity),
+	m_index(indexSizeFor(capacity), EMPTY),
+	m_mask(m_index.size() - 1)
+{
+	if (capacity == 0)
+		throw std::runtime_error("FitnessCache error: capacity must be positive");
+}
+
+bool FitnessCache::matches(uint32_t slot, const Genome& genome, uint64_t hash) const
+{
+	return m_hashes[slot] == hash && std::memcmp(&m_keys[slot * m_words], genome.data(), m_words * sizeof(Genome::word_t)) == 0;
+}
+
+size_t FitnessCache::probe(const Genome& genome, uint64_t hash) const
+{
+	size_t pos = hash & m_mask;
+	while (m_index[pos] != EMPTY && !matches(m_index[pos], genome, hash))
+		pos = (pos + 1) & m_mask;
+	return pos;
+}
+
+std::optional<int> FitnessCache::find(const Genome& genome, uint64_t hash)
+{
+	if (genome.size() != m_genomeLength)
+	{
+		++m_stats.misses;
+		return std::nullopt;
+	}
+
+	const uint32_t slot = m_index[probe(genome, hash)];
+	if (slot == EMPTY)
+	{
+		++m_stats.misses;
+		return std::nullopt;
+	}
+
+	++m_stats.hits;
+	m_referenced[slot] = 1;
+	return m_weights[slot];
+}
+
+void FitnessCache::insert(const Genome& genome, uint64_t hash, int weight)
+{
+	if (genome.size() != m_genomeLength)
+		throw std::runtime_error("FitnessCache::insert error: genome length differs from the cache key length");
+
+	size_t pos = probe(genome, hash);
+	if (m_index[pos] != EMPTY)
+	{
+		m_weights[m_index[pos]] = weight;
+		return;
+	}
+
+	uint32_t slot;
+	if (m_size < capacity())
+	{
+		slot = static_cast<uint32_t>(m_size++);
+	}
+	else
+	{
+		slot = evict();
+		// the eviction may have shifted entries into the probed position
+		pos = probe(genome, hash);
+	}
+
+	std::memcpy(&m_keys[slot * m_words], genome.data(), m_words * sizeof(Genome::word_t));
+	m_hashes[slot]	   = hash;
+	m_weights[slot]	   = weight;
+	m_referenced[slot] = 0;
+	m_index[pos]	   = slot;
+}
+
+uint32_t FitnessCache::evict()
+{
+	// second chance: referenced entries are spared once
+	for (;;)
+	{
+		const auto slot = static_cast<uint32_t>(m_hand);
+		m_hand			= (m_hand + 1) % capacity();
+
+		if (m_referenced[slot])
+		{
+			m_referenced[slot] = 0;
+			continue;
+		}
+
+		size_t pos = m_hashes[slot] & m_mask;
+		while (m_index[pos] != slot)
+			pos = (pos + 1) & m_mask;
+
+		eraseFromIndex(pos);
+		++m_stats.evictions;
+		return slot;
+	}
+}
+
+void FitnessCache::eraseFromIndex(size_t pos)
+{
+	// backward-shift deletion keeps probe sequences intact without tombstones
+	size_t hole = pos;
+	size_t next = (hole + 1) & m_mask;
+	while (m_index[next] != EMPTY)
+	{
+		const size_t home = m_hashes[m_index[next]] & m_mask;
+		// the entry may move into the hole unless its home lies cyclically in (hole, next]
+		const bool homeBetween = hole <= next ? (home > hole && home <= next) : (home > hole || home <= next);
+		if (!homeBetween)
+		{
+			m_index[hole] = m_index[next];
+			hole		  = next;
+		}
+		next = (next + 1) & m_mask;
+	}
+	m_index[hole] = EMPTY;
+}
+
+void FitnessCache::clear()
+{
+	std::fill(m_index.begin(), m_index.end(), EMPTY);
+	std::fill(m_referenced.begin(), m_referenced.end(), 0);
+	m_size = 0;
+	m_hand = 0;
+}
+
+void FitnessCache::restore(const Genome::word_t* keys, const uint64_t* hashes, const int* weights, size_t count)
+{
+	clear();
+	m_size = std::min(count, capacity());
+
+	std::copy(keys, keys + m_size * m_words, m_keys.begin());
+	std::copy(hashes, hashes + m_size, m_hashes.begin());
+	std::copy(weights, weights + m_size, m_weights.begin());
+
+	// the keys are distinct, so every slot just takes the first free position of its probe sequence
+	for (size_t slot = 0; slot < m_size; ++slot)
+	{
+		size_t pos = m_hashes[slot] & m_mask;
+		while (m_index[pos] != EMPTY)
+			pos = (pos + 1) & m_mask;
+		m_index[pos] = static_cast<uint32_t>(slot);
+	}
+}
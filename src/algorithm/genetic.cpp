@@ -1,218 +1,556 @@
 #include "algorithm/genetic.h"
+#include "utility/bits.h"
 #include <spdlog/spdlog.h>
-#include <random>
 #include <stdexcept>
 #include <exception>
 #include <algorithm>
 #include <iterator>
 #include <thread>
+#include <cmath>
+#include <string>
 
 using namespace GeneticAlgorithm;
 
-static WeightedPopulation g_weightedPopulation{};
-static uint16_t g_maxWeight;
-
 Genome Genetic::generateGenome(size_t genomeLength)
 {
-    Genome result(genomeLength, 0);
-
-    double p = 0.5; // we can control probability of 1
+    return generateGenome(genomeLength, Random::threadRng());
+}
 
-    std::random_device rand_dev;
-    std::mt19937 generator(rand_dev());
-    std::bernoulli_distribution d(p);
+Genome Genetic::generateGenome(size_t genomeLength, Rng& rng)
+{
+    Genome result(genomeLength);
 
-    for (size_t n = 0; n < genomeLength; ++n) {
-        result[n] = d(generator);
-    }
+    // every bit of a 64-bit draw is 1 with probability 0.5, so a whole word is filled at once
+    rng.fillBits(result.data(), result.wordCount());
+    result.clearTail();
 
     return result;
 }
 
 Population Genetic::generatePopulation(size_t populationSize, size_t genomeLength)
 {
-    Population result(populationSize);
+    return generatePopulation(populationSize, genomeLength, Random::threadRng());
+}
+
+Population Genetic::generatePopulation(size_t populationSize, size_t genomeLength, Rng& rng)
+{
+    Population result(populationSize, Genome(genomeLength));
 
-    for (size_t n = 0; n < populationSize; ++n)
+    for (auto& genome : result)
     {
-        result[n] = generateGenome(genomeLength);
+        rng.fillBits(genome.data(), genome.wordCount());
+        genome.clearTail();
     }
     spdlog::info("Population generated");
     return result;
 }
 
 std::tuple<Genome, Genome> Genetic::singlePointCrossover(Genome first, Genome second)
+{
+    return singlePointCrossover(std::move(first), std::move(second), Random::threadRng());
+}
+
+std::tuple<Genome, Genome> Genetic::singlePointCrossover(Genome first, Genome second, Rng& rng)
 {
     if(first.size() != second.size())
         throw std::runtime_error("Genetic::singlePointCrossover error: Both genomes must have the same length");
 
     auto length = first.size();
     if (length < 2)
-        return { first, second };
+        return std::make_tuple(std::move(first), std::move(second));
+
+    auto p = rng.uniform(length);
+
+    // offspring take bits [0, p) from one parent and [p, length) from the other:
+    // whole words are swapped past the cut, the word holding the cut is blended with a mask
+    const size_t cutWord = p / Genome::BITS_PER_WORD;
+    const Genome::word_t lowMask = (Genome::word_t{1} << (p % Genome::BITS_PER_WORD)) - 1;
+
+    Genome::word_t* a = first.data();
+    Genome::word_t* b = second.data();
+
+    const Genome::word_t diff = (a[cutWord] ^ b[cutWord]) & ~lowMask;
+    a[cutWord] ^= diff;
+    b[cutWord] ^= diff;
+
+    for (size_t w = cutWord + 1; w < first.wordCount(); ++w)
+        std::swap(a[w], b[w]);
+
+    SPDLOG_TRACE("Crossover passed: a = {}, b = {}", first.size(), second.size());
+    return std::make_tuple(std::move(first), std::move(second));
+}
+
+// sizes the offspring like the parents; false when there are no bits to cross
+static bool prepareOffspring(GenomeView first, GenomeView second, Genome& offspringA, Genome& offspringB, const char* name)
+{
+    if(first.size() != second.size())
+        throw std::runtime_error(std::string("Genetic::") + name + " error: Both genomes must have the same length");
+
+    offspringA.resize(first.size());
+    offspringB.resize(first.size());
+    return first.size() != 0;
+}
+
+// bits of word w that lie below bit idx of the genome
+static inline Genome::word_t bitsBelow(size_t w, size_t idx)
+{
+    const size_t wordStart = w * Genome::BITS_PER_WORD;
+    if (idx <= wordStart)
+        return 0;
+    if (idx - wordStart >= Genome::BITS_PER_WORD)
+        return ~Genome::word_t{0};
+    return (Genome::word_t{1} << (idx - wordStart)) - 1;
+}
+
+// offspringA takes bits [lo, hi) from second and the rest from first, offspringB the other way round
+static void exchangeSegment(GenomeView first, GenomeView second, Genome& offspringA, Genome& offspringB, size_t lo, size_t hi)
+{
+    const Genome::word_t* f = first.data();
+    const Genome::word_t* s = second.data();
+    Genome::word_t* a = offspringA.data();
+    Genome::word_t* b = offspringB.data();
+
+    const auto blend = [&](size_t w) {
+        const Genome::word_t keep = bitsBelow(w, lo) | ~bitsBelow(w, hi);
+        a[w] = (f[w] & keep) | (s[w] & ~keep);
+        b[w] = (s[w] & keep) | (f[w] & ~keep);
+    };
+
+    // only the words holding a cut are blended, the others come whole from one parent
+    const size_t words = first.wordCount();
+    const size_t loWord = std::min(lo / Genome::BITS_PER_WORD, words);
+    const size_t hiWord = std::min(hi / Genome::BITS_PER_WORD, words);
+
+    for (size_t w = 0; w < loWord; ++w)
+    {
+        a[w] = f[w];
+        b[w] = s[w];
+    }
+    if (loWord < words)
+        blend(loWord);
+
+    for (size_t w = loWord + 1; w < hiWord; ++w)
+    {
+        a[w] = s[w];
+        b[w] = f[w];
+    }
+    if (hiWord > loWord && hiWord < words)
+        blend(hiWord);
+
+    for (size_t w = hiWord + 1; w < words; ++w)
+    {
+        a[w] = f[w];
+        b[w] = s[w];
+    }
+}
+
+void Genetic::singlePointCrossover(GenomeView first, GenomeView second, Genome& offspringA, Genome& offspringB, Rng& rng)
+{
+    if (!prepareOffspring(first, second, offspringA, offspringB, "singlePointCrossover"))
+        return;
 
-    std::random_device rand_dev;
-    std::mt19937 generator(rand_dev());
-    std::uniform_int_distribution<int>  distr(0, length - 1);
+    // a single bit cannot be cut, the offspring are copies of the parents like those of the tuple overload
+    auto length = first.size();
+    auto p = length < 2 ? length : rng.uniform(length);
+
+    // offspring take bits [0, p) from one parent and [p, length) from the other
+    exchangeSegment(first, second, offspringA, offspringB, p, length);
+    SPDLOG_TRACE("Crossover passed: a = {}, b = {}", offspringA.size(), offspringB.size());
+}
+
+void Genetic::twoPointCrossover(GenomeView first, GenomeView second, Genome& offspringA, Genome& offspringB, Rng& rng)
+{
+    if (!prepareOffspring(first, second, offspringA, offspringB, "twoPointCrossover"))
+        return;
+
+    // two distinct cuts in [0, length], so the exchanged segment is never empty and may end at the last bit
+    auto length = first.size();
+    size_t lo = length;
+    size_t hi = length;
+    if (length >= 2)
+    {
+        lo = rng.uniform(length + 1);
+        hi = rng.uniform(length);
+        if (hi >= lo)
+            ++hi;
+        else
+            std::swap(lo, hi);
+    }
+
+    exchangeSegment(first, second, offspringA, offspringB, lo, hi);
+}
+
+void Genetic::uniformCrossover(GenomeView first, GenomeView second, Genome& offspringA, Genome& offspringB, Rng& rng)
+{
+    if (!prepareOffspring(first, second, offspringA, offspringB, "uniformCrossover"))
+        return;
+
+    const Genome::word_t* f = first.data();
+    const Genome::word_t* s = second.data();
+    Genome::word_t* a = offspringA.data();
+    Genome::word_t* b = offspringB.data();
+
+    // both parents have a clear tail, so whatever the mask picks there is 0
+    for (size_t w = 0; w < first.wordCount(); ++w)
+    {
+        const Genome::word_t mask = rng();
+        a[w] = (f[w] & mask) | (s[w] & ~mask);
+        b[w] = (s[w] & mask) | (f[w] & ~mask);
+    }
+}
 
-    auto p = distr(generator);
+void Genetic::noteAlignedCrossover(GenomeView first, GenomeView second, Genome& offspringA, Genome& offspringB, Rng& rng)
+{
+    if (!prepareOffspring(first, second, offspringA, offspringB, "noteAlignedCrossover"))
+        return;
 
-    Genome a;
-    Genome b;
+    const size_t notes = first.noteCount();
+    // never at the start, so the offspring always take notes from both parents
+    const size_t p = notes < 2 ? first.size() : (1 + rng.uniform(notes - 1)) * Genome::BITS_PER_NOTE;
 
-    std::merge(first.begin(), first.begin() + p, second.begin()+p, second.end(), std::back_inserter(a));
-    std::merge(second.begin(), second.begin() + p, first.begin()+p, first.end(), std::back_inserter(b));
-    spdlog::info("Crossover passed: a = {}, b = {}", a.size(), b.size());
-    return std::make_tuple( a, b );
+    exchangeSegment(first, second, offspringA, offspringB, p, first.size());
+}
+
+void Genetic::barAlignedCrossover(GenomeView first, GenomeView second, Genome& offspringA, Genome& offspringB, Rng& rng)
+{
+    if (!prepareOffspring(first, second, offspringA, offspringB, "barAlignedCrossover"))
+        return;
+
+    // between two whole bars, never at the start
+    const size_t bars = first.size() / Genome::BITS_PER_BAR;
+    const size_t p = bars < 2 ? first.size() : (1 + rng.uniform(bars - 1)) * Genome::BITS_PER_BAR;
+
+    exchangeSegment(first, second, offspringA, offspringB, p, first.size());
+}
+
+void Genetic::crossover(CrossoverType type, GenomeView first, GenomeView second, Genome& offspringA, Genome& offspringB, Rng& rng)
+{
+    switch (type)
+    {
+    case CrossoverType::SINGLE_POINT:
+        return singlePointCrossover(first, second, offspringA, offspringB, rng);
+    case CrossoverType::TWO_POINT:
+        return twoPointCrossover(first, second, offspringA, offspringB, rng);
+    case CrossoverType::UNIFORM:
+        return uniformCrossover(first, second, offspringA, offspringB, rng);
+    case CrossoverType::NOTE_ALIGNED:
+        return noteAlignedCrossover(first, second, offspringA, offspringB, rng);
+    case CrossoverType::BAR_ALIGNED:
+        return barAlignedCrossover(first, second, offspringA, offspringB, rng);
+    }
+    throw std::runtime_error("Genetic::crossover error: unknown crossover type");
+}
+
+void Genetic::crossover(CrossoverType type, const Population& population, const ParentPairs& pairs, utility::Span<Genome> offspring, Rng& rng)
+{
+    if (offspring.size() != 2 * pairs.size())
+        throw std::runtime_error("Genetic::crossover error: offspring must hold two genomes per parent pair");
+
+    for (size_t k = 0; k < pairs.size(); ++k)
+        crossover(type, population[pairs[k].first], population[pairs[k].second], offspring[2 * k], offspring[2 * k + 1], rng);
 }
 
 void Genetic::mutation(Genome& genome, size_t num, float probability)
 {
-    auto length = genome.size();
+    mutation(genome, num, probability, Random::threadRng());
+}
 
-    std::random_device rand_dev;
-    std::mt19937 generator(rand_dev());
-    std::uniform_real_distribution<> randDouble(0, 1);
-    std::uniform_int_distribution<int>  randInt(0, length - 1);
+void Genetic::mutation(Genome& genome, size_t num, float probability, Rng& rng)
+{
+    auto length = genome.size();
+    if (length == 0)
+        return;
 
+    // compared in the generator's double precision
+    const double threshold = static_cast<double>(probability);
     for (size_t i = 0; i < num; ++i)
     {
-        auto p = randDouble(generator);
-        auto idx = randInt(generator);
+        auto p = rng.uniformReal();
+        auto idx = rng.uniform(length);
 
-        if (p < probability)
-            genome[idx] = static_cast<bool>(genome[idx]) ^ 1;
+        if (p < threshold)
+            genome.flip(idx);
     }
-	spdlog::info("Mutation passed");
+	SPDLOG_TRACE("Mutation passed");
 }
 
-int Genetic::populationFitness()
+void Genetic::mutation(utility::Span<Genome> genomes, size_t num, float probability, Rng& rng)
+{
+    for (auto& genome : genomes)
+        mutation(genome, num, probability, rng);
+}
+
+size_t Genetic::flipMutation(Genome& genome, double rate, Rng& rng)
+{
+    return flipMutation(utility::Span<Genome>(&genome, 1), rate, rng);
+}
+
+size_t Genetic::flipMutation(utility::Span<Genome> genomes, double rate, Rng& rng)
+{
+    if (!(rate > 0))
+        return 0;
+
+    // Bits kept before the next flip: P(gap = k) = (1 - rate)^k * rate, drawn by inverting its distribution.
+    // With rate 1 the logarithm is -inf and every gap is 0.
+    const double logKeep = std::log1p(-std::min(rate, 1.0));
+    const auto gap = [&] { return std::floor(std::log(1.0 - rng.uniformReal()) / logKeep); };
+
+    size_t flips = 0;
+    double skip = gap();
+    for (auto& genome : genomes)
+    {
+        const size_t length = genome.size();
+        if (skip >= static_cast<double>(length))
+        {
+            skip -= static_cast<double>(length);
+            continue;
+        }
+
+        Genome::word_t* words = genome.data();
+        size_t idx = static_cast<size_t>(skip);
+        while (true)
+        {
+            words[idx / Genome::BITS_PER_WORD] ^= Genome::word_t{1} << (idx % Genome::BITS_PER_WORD);
+            ++flips;
+
+            // a gap running past the genome carries over into the next one
+            const double next = gap();
+            const size_t left = length - idx - 1;
+            if (next >= static_cast<double>(left))
+            {
+                skip = next - static_cast<double>(left);
+                break;
+            }
+            idx += 1 + static_cast<size_t>(next);
+        }
+    }
+    SPDLOG_TRACE("Flip mutation passed: {} flips", flips);
+    return flips;
+}
+
+int Genetic::populationFitness(const WeightedPopulation& weightedPopulation)
 {
     int sum = 0;
 
-    for(const auto& [weight, _] : g_weightedPopulation)
+    for(const auto& [_, weight] : weightedPopulation)
 		sum += weight;
 
     return sum;
 }
 
-std::tuple<Genome, Genome> Genetic::selectionPair(const Population& population)
+std::tuple<GenomeView, GenomeView> Genetic::selectionPair(const Population& population, const WeightedPopulation& weightedPopulation)
 {
-    std::array<Genome, 2> result{};
+    return selectionPair(population, weightedPopulation, Random::threadRng());
+}
+
+std::tuple<GenomeView, GenomeView> Genetic::selectionPair(const Population& population, const WeightedPopulation& weightedPopulation, Rng& rng)
+{
+    const auto [first, second] = selectionPairIndices(weightedPopulation, rng);
+    SPDLOG_TRACE("Selection pair returned");
+    return std::make_tuple(GenomeView(population[first]), GenomeView(population[second]));
+}
+
+std::pair<size_t, size_t> Genetic::selectionPairIndices(const WeightedPopulation& weightedPopulation, Rng& rng)
+{
+    if (weightedPopulation.empty())
+        throw std::runtime_error("Genetic::selectionPairIndices error: weighted population is empty");
 
-    int sumWeights = populationFitness();
+    std::array<size_t, 2> result{};
 
-    std::random_device rand_dev;
-    std::mt19937 generator(rand_dev());
-    std::uniform_int_distribution<int>  randInt(0, sumWeights);
+    // negative weights count as 0, like in Selector; the sum is kept in 64 bits
+    uint64_t sumWeights = 0;
+    for (const auto& [_, weight] : weightedPopulation)
+        sumWeights += static_cast<uint64_t>(std::max(weight, 0));
 
     for (size_t i = 0; i < 2; ++i)
     {
-        int rnd = randInt(generator);
-        for (const auto& [geneIdx, weight] : g_weightedPopulation)
+        // nothing to weight by, every genome is equally likely
+        if (sumWeights == 0)
         {
-            if (rnd < weight)
+            result[i] = weightedPopulation[rng.uniform(weightedPopulation.size())].first;
+            continue;
+        }
+
+        uint64_t rnd = rng.uniform(sumWeights);
+        result[i] = weightedPopulation.back().first;
+        for (const auto& [geneIdx, weight] : weightedPopulation)
+        {
+            const auto clamped = static_cast<uint64_t>(std::max(weight, 0));
+            if (rnd < clamped)
             {
-				result[i] = population[geneIdx];
+				result[i] = geneIdx;
                 break;
             }
-            rnd -= weight;
+            rnd -= clamped;
         }
     }
-    spdlog::info("Selection pair returned");
-    return std::make_tuple(result[0], result[1]);
+    return {result[0], result[1]};
 }
 
-void Genetic::generateWeightedDistribution(const Population& population, FitnessFunc fitnessFunc)
+static void sortWeightedPopulation(WeightedPopulation& weightedPopulation)
 {
+    // sorted in ascending order
+	std::sort(weightedPopulation.begin(), weightedPopulation.end(), [&](auto& a, auto& b) { return a.second < b.second; });
+
+	SPDLOG_DEBUG("Weighted population generated.");
+}
+
+void Genetic::generateWeightedDistribution(const Population& population, const FitnessFunc& fitnessFunc, WeightedPopulation& weightedPopulation)
+{
+    weightedPopulation.resize(population.size());
+
     for (size_t i = 0; i < population.size(); ++i)
     {
-        auto gene = population[i];
-        int weight = fitnessFunc(gene);
-        g_weightedPopulation[i] = std::make_pair(i, weight);
+        int weight = fitnessFunc(population[i]);
+        weightedPopulation[i] = std::make_pair(static_cast<uint32_t>(i), weight);
     }
 
-    // sorted in ascending order
-	std::sort(g_weightedPopulation.begin(), g_weightedPopulation.end(), [&](auto& a, auto& b) { return a.second < b.second; });
+    sortWeightedPopulation(weightedPopulation);
+}
 
-	spdlog::info("Weighted population generated.");
+void Genetic::evaluatePopulation(const Population& population, const BatchFitnessFunc& fitnessFunc, utility::ThreadPool& pool, std::vector<int>& weights, size_t grain)
+{
+    weights.resize(population.size());
+    evaluatePopulation(utility::Span<const Genome>(population), fitnessFunc, pool, utility::Span<int>(weights), grain);
 }
 
-Population Genetic::sortPopulation(const Population& population, FitnessFunc fitnessFunc, bool reversed)
+void Genetic::evaluatePopulation(utility::Span<const Genome> genomes, const BatchFitnessFunc& fitnessFunc, utility::ThreadPool& pool, utility::Span<int> weights, size_t grain)
 {
-    Population result{};
+    if (weights.size() != genomes.size())
+        throw std::runtime_error("Genetic::evaluatePopulation error: one weight per genome is required");
 
-    generateWeightedDistribution(population, fitnessFunc);
+    // every chunk writes only its own slots, so the result does not depend on scheduling
+    pool.parallelFor(genomes.size(), [&](size_t begin, size_t end) {
+        fitnessFunc(genomes.subspan(begin, end - begin), weights.subspan(begin, end - begin));
+    }, grain);
+}
+
+void Genetic::weightPopulation(const std::vector<int>& weights, WeightedPopulation& weightedPopulation)
+{
+    weightedPopulation.resize(weights.size());
+    for (size_t i = 0; i < weights.size(); ++i)
+        weightedPopulation[i] = std::make_pair(static_cast<uint32_t>(i), weights[i]);
+
+    sortWeightedPopulation(weightedPopulation);
+}
 
-    // size should be equal
-    /*if (wp.size() != result.size())
-        throw std::runtime_error("Genetic::sortPopulation error: size discrepancy");*/
+void Genetic::generateWeightedDistribution(const Population& population, const BatchFitnessFunc& fitnessFunc, utility::ThreadPool& pool, WeightedPopulation& weightedPopulation)
+{
+    std::vector<int> weights;
+    evaluatePopulation(population, fitnessFunc, pool, weights);
+    weightPopulation(weights, weightedPopulation);
+}
+
+Population Genetic::sortPopulation(const Population& population, const WeightedPopulation& weightedPopulation, bool reversed)
+{
+    if (weightedPopulation.size() != population.size())
+        throw std::runtime_error("Genetic::sortPopulation error: size discrepancy");
+
+    Population result{};
+    result.reserve(population.size());
 
     if (reversed)
     {
         // descending order
-		for(auto it = g_weightedPopulation.rbegin(); it != g_weightedPopulation.rend(); ++it)
+		for(auto it = weightedPopulation.rbegin(); it != weightedPopulation.rend(); ++it)
             result.push_back(population[it->first]);
     }
     else
     {
 		// ascending order
-		for(auto it = g_weightedPopulation.begin(); it != g_weightedPopulation.end(); ++it)
+		for(auto it = weightedPopulation.begin(); it != weightedPopulation.end(); ++it)
 			result.push_back(population[it->first]);
     }
 
-	g_maxWeight = g_weightedPopulation.rbegin()->second;
-	spdlog::info("Population sorted. Max weight: {}", g_maxWeight);
+	SPDLOG_DEBUG("Population sorted. Max weight: {}", weightedPopulation.empty() ? 0 : weightedPopulation.rbegin()->second);
 
     return result;
 }
 
-uint16_t Genetic::getMaxWeight()
-{
-	return g_maxWeight;
-}
-
-//Population Genetic::runEvolution(FitnessFunc fitnessFunc, uint32_t fitnessLimit, uint32_t generationLimit)
-//{
-//    Population population = generatePopulation();
-//
-//    for (size_t genNum = 0; genNum < generationLimit; ++genNum)
-//    {
-//        Population nextGeneration;
-//        Population sortedPopulation = sortPopulation(population, fitnessFunc);
-//
-//        if(g_maxWeight >= fitnessLimit)
-//            break;
-//
-//        nextGeneration.push_back(sortedPopulation[0]);
-//        nextGeneration.push_back(sortedPopulation[1]);
-//
-//        for (size_t i = 0; i < static_cast<size_t>((sortedPopulation.size() / 2) - 1); ++i)
-//        {
-//            auto parents = selectionPair(sortedPopulation);
-//
-//            Genome offspringA, offspringB;
-//
-//            try
-//			{
-//				std::tie(offspringA, offspringB) = singlePointCrossover(std::get<0>(parents), std::get<1>(parents));
-//
-//                mutation(offspringA);
-//				mutation(offspringB);
-//
-//				nextGeneration.push_back(offspringA);
-//				nextGeneration.push_back(offspringB);
-//			}
-//			catch(std::exception& e)
-//			{
-//				spdlog::error("Exception: {}", e.what());
-//            }
-//
-//            
-//        }
-//        population = nextGeneration;
-//    }
-//    spdlog::info("Evolution is finished");
-//
-//    
-//    return population;
-//}
\ No newline at end of file
+Population Genetic::sortPopulation(const Population& population, const FitnessFunc& fitnessFunc, WeightedPopulation& weightedPopulation, bool reversed)
+{
+    generateWeightedDistribution(population, fitnessFunc, weightedPopulation);
+    return sortPopulation(population, weightedPopulation, reversed);
+}
+
+void Genetic::sortPopulation(const Population& population, const WeightedPopulation& weightedPopulation, std::vector<GenomeView>& sorted, bool reversed)
+{
+    if (weightedPopulation.size() != population.size())
+        throw std::runtime_error("Genetic::sortPopulation error: size discrepancy");
+
+    const size_t size = population.size();
+    sorted.resize(size);
+    for (size_t i = 0; i < size; ++i)
+        sorted[i] = population[weightedPopulation[reversed ? size - 1 - i : i].first];
+}
+
+void Genetic::permutePopulation(Population& population, WeightedPopulation& weightedPopulation, bool reversed)
+{
+    if (weightedPopulation.size() != population.size())
+        throw std::runtime_error("Genetic::permutePopulation error: size discrepancy");
+
+    const size_t size = population.size();
+    // slot i receives the genome at source(i); every cycle of the permutation is rotated with moves,
+    // which only exchange the word buffers
+    auto source = [&](size_t i) { return weightedPopulation[reversed ? size - 1 - i : i].first; };
+    std::vector<bool> placed(size, false);
+
+    for (const auto& entry : weightedPopulation)
+    {
+        if (entry.first >= size || placed[entry.first])
+            throw std::runtime_error("Genetic::permutePopulation error: weighted population is not a permutation");
+        placed[entry.first] = true;
+    }
+    placed.assign(size, false);
+
+    for (size_t start = 0; start < size; ++start)
+    {
+        if (placed[start])
+            continue;
+
+        Genome held = std::move(population[start]);
+        size_t slot = start;
+        for (size_t from = source(slot); from != start; from = source(slot))
+        {
+            population[slot] = std::move(population[from]);
+            placed[slot] = true;
+            slot = from;
+        }
+        population[slot] = std::move(held);
+        placed[slot] = true;
+    }
+
+    for (size_t pos = 0; pos < size; ++pos)
+        weightedPopulation[pos].first = static_cast<uint32_t>(reversed ? size - 1 - pos : pos);
+}
+
+size_t Genetic::changedNotes(GenomeView base, GenomeView genome, utility::Span<NoteRange> ranges)
+{
+    if (base.size() != genome.size())
+        throw std::runtime_error("Genetic::changedNotes error: Both genomes must have the same length");
+    if (ranges.empty())
+        throw std::runtime_error("Genetic::changedNotes error: no room for a range");
+
+    const size_t notes = genome.noteCount();
+    size_t count = 0;
+
+    for (size_t w = 0; w < genome.wordCount(); ++w)
+    {
+        const Genome::word_t diff = base.word(w) ^ genome.word(w);
+        if (diff == 0)
+            continue;
+
+        // bits past the last whole note belong to no note
+        const size_t wordStart = w * Genome::NOTES_PER_WORD;
+        const size_t first = wordStart + utility::lowestBit(diff) / Genome::BITS_PER_NOTE;
+        const size_t last = std::min(notes, wordStart + utility::highestBit(diff) / Genome::BITS_PER_NOTE + 1);
+        if (first >= last)
+            continue;
+
+        if (count > 0 && (count == ranges.size() || first <= ranges[count - 1].last + Genome::NOTES_PER_WORD))
+            ranges[count - 1].last = last;
+        else
+            ranges[count++] = NoteRange{first, last};
+    }
+    return count;
+}
@@ -0,0 +1,148 @@
+#include "algorithm/genome.h"
+#include "algorithm/note_events.h"
+#include <memory>
+#include <utility>
+
+using namespace GeneticAlgorithm;
+
+Genome::Genome(size_t length, bool value) : m_words(wordsForBits(length), value ? ~word_t{0} : word_t{0}), m_length(length)
+{
+	clearTail();
+}
+
+Genome::Genome(GenomeView view) : m_words(view.data(), view.data() + view.wordCount()), m_length(view.size())
+{
+}
+
+Genome::Genome(const Genome& other) : m_words(other.m_words), m_length(other.m_length)
+{
+}
+
+Genome& Genome::operator=(const Genome& other)
+{
+	if (this != &other)
+	{
+		dropNoteEvents();
+		m_words	 = other.m_words;
+		m_length = other.m_length;
+	}
+	return *this;
+}
+
+Genome::Genome(Genome&& other) noexcept :
+	m_words(std::move(other.m_words)), m_length(std::exchange(other.m_length, 0)), m_noteEvents(other.m_noteEvents.exchange(nullptr, std::memory_order_acq_rel))
+{
+}
+
+Genome& Genome::operator=(Genome&& other) noexcept
+{
+	if (this != &other)
+	{
+		m_words	 = std::move(other.m_words);
+		m_length = std::exchange(other.m_length, 0);
+		delete m_noteEvents.exchange(other.m_noteEvents.exchange(nullptr, std::memory_order_acq_rel), std::memory_order_acq_rel);
+	}
+	return *this;
+}
+
+Genome::~Genome()
+{
+	delete m_noteEvents.load(std::memory_order_acquire);
+}
+
+void Genome::releaseNoteEvents()
+{
+	delete m_noteEvents.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+void Genome::assign(GenomeView view)
+{
+	dropNoteEvents();
+	m_words.resize(view.wordCount());
+	std::copy(view.data(), view.data() + view.wordCount(), m_words.begin());
+	m_length = view.size();
+}
+
+void Genome::resize(size_t length)
+{
+	dropNoteEvents();
+	m_words.resize(wordsForBits(length), 0);
+	m_length = length;
+	clearTail();
+}
+
+void Genome::set(size_t idx, bool value)
+{
+	dropNoteEvents();
+	const word_t mask = word_t{1} << (idx % BITS_PER_WORD);
+	word_t& w		  = m_words[idx / BITS_PER_WORD];
+	w				  = value ? (w | mask) : (w & ~mask);
+}
+
+void Genome::setNibble(size_t noteIdx, uint8_t value)
+{
+	dropNoteEvents();
+	const size_t shift = (noteIdx % NOTES_PER_WORD) * BITS_PER_NOTE;
+	word_t& w		   = m_words[noteIdx / NOTES_PER_WORD];
+	w				   = (w & ~(word_t{0xF} << shift)) | (word_t{value & 0xFu} << shift);
+}
+
+void Genome::setWord(size_t idx, word_t value)
+{
+	dropNoteEvents();
+	m_words[idx] = value;
+	if (idx + 1 == m_words.size())
+		clearTail();
+}
+
+Genome::word_t Genome::tailMask() const
+{
+	const size_t used = m_length % BITS_PER_WORD;
+	return used == 0 ? ~word_t{0} : (word_t{1} << used) - 1;
+}
+
+void Genome::clearTail()
+{
+	if (!m_words.empty())
+		m_words.back() &= tailMask();
+}
+
+// multiply-xorshift mixing of every word, finished with the murmur3 finalizer
+static uint64_t hashWords(const Genome::word_t* words, size_t wordCount, size_t length)
+{
+	uint64_t h = 0x9E3779B97F4A7C15ull ^ length;
+	for (size_t i = 0; i < wordCount; ++i)
+	{
+		h ^= words[i] * 0xBF58476D1CE4E5B9ull;
+		h = (h << 31 | h >> 33) * 0x94D049BB133111EBull;
+	}
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDull;
+	h ^= h >> 33;
+	return h;
+}
+
+uint64_t Genome::hash() const
+{
+	return hashWords(m_words.data(), m_words.size(), m_length);
+}
+
+uint64_t GenomeView::hash() const
+{
+	return hashWords(m_words, wordCount(), m_length);
+}
+
+const NoteEvents& Genome::noteEvents() const
+{
+	if (const NoteEvents* events = m_noteEvents.load(std::memory_order_acquire))
+		return *events;
+
+	// readers racing here decode the same bits; the first one publishes and the others drop their copy
+	auto decoded = std::make_unique<NoteEvents>();
+	NoteEvents::decode(*this, *decoded);
+
+	const NoteEvents* published = nullptr;
+	if (m_noteEvents.compare_exchange_strong(published, decoded.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+		return *decoded.release();
+	return *published;
+}
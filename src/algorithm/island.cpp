@@ -0,0 +1,180 @@
+#include "algorithm/island.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+using namespace GeneticAlgorithm;
+
+IslandModel::IslandModel(const IslandConfig& config) : m_config(config)
+{
+	if (m_config.islands == 0)
+		m_config.islands = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+	const size_t offspring = m_config.evolution.populationSize - m_config.evolution.elites;
+	if (m_config.migrants > offspring)
+		throw std::runtime_error("IslandModel error: more migrants than non-elite genomes in an island");
+
+	if (m_config.migrationInterval == 0)
+		throw std::runtime_error("IslandModel error: migration interval must be positive");
+
+	const uint64_t seed = m_config.evolution.seed ? *m_config.evolution.seed : Random::threadRng()();
+
+	m_islands.reserve(m_config.islands);
+	for (size_t i = 0; i < m_config.islands; ++i)
+	{
+		EvolutionConfig islandConfig = m_config.evolution;
+		islandConfig.seed			 = Rng::forStream(seed, i)();
+
+		auto island = std::make_unique<Island>(islandConfig);
+		island->outbox.assign(m_config.migrants, Genome(islandConfig.genomeLength));
+		m_islands.push_back(std::move(island));
+	}
+}
+
+IslandModel::~IslandModel() = default;
+
+void IslandModel::run(const FitnessFunc& fitnessFunc, int fitnessLimit, uint32_t generationLimit)
+{
+	m_stop.store(false);
+	m_error = nullptr;
+
+	std::vector<std::thread> threads;
+	threads.reserve(m_islands.size());
+	for (size_t i = 0; i < m_islands.size(); ++i)
+		threads.emplace_back(&IslandModel::runIsland, this, i, std::cref(fitnessFunc), fitnessLimit, generationLimit);
+
+	for (auto& thread : threads)
+		thread.join();
+
+	if (m_error)
+		std::rethrow_exception(std::exchange(m_error, nullptr));
+
+	spdlog::info("Island evolution is finished. Max weight: {}", maxWeight());
+}
+
+void IslandModel::runIsland(size_t idx, const FitnessFunc& fitnessFunc, int fitnessLimit, uint32_t generationLimit)
+{
+	// an exception leaving the thread would terminate the program, so it is handed to run() instead
+	try
+	{
+		evolveIsland(idx, fitnessFunc, fitnessLimit, generationLimit);
+	}
+	catch (...)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_errorMutex);
+			if (!m_error)
+				m_error = std::current_exception();
+		}
+		m_stop.store(true);
+	}
+}
+
+void IslandModel::evolveIsland(size_t idx, const FitnessFunc& fitnessFunc, int fitnessLimit, uint32_t generationLimit)
+{
+	Evolution& evolution = m_islands[idx]->evolution;
+	if (evolution.population().empty())
+		evolution.initPopulation();
+
+	for (uint32_t genNum = 0; genNum < generationLimit; ++genNum)
+	{
+		evolution.evaluate(fitnessFunc);
+
+		if (evolution.maxWeight() >= fitnessLimit)
+			m_stop.store(true);
+
+		if (m_stop.load() || genNum + 1 == generationLimit)
+			break;
+
+		const bool migrate = m_islands.size() > 1 && m_config.migrants > 0 && (genNum + 1) % m_config.migrationInterval == 0;
+		if (migrate)
+			emigrate(*m_islands[idx]);
+
+		evolution.breed();
+
+		if (migrate)
+			immigrate(idx);
+	}
+}
+
+void IslandModel::emigrate(Island& island)
+{
+	// a batch nobody picked up yet is stale and gets overwritten; only a batch being read is left alone
+	int expected = EMPTY;
+	if (!island.outboxState.compare_exchange_strong(expected, WRITING, std::memory_order_acquire))
+	{
+		expected = FULL;
+		if (!island.outboxState.compare_exchange_strong(expected, WRITING, std::memory_order_acquire))
+		{
+			m_dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		m_dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	const auto& population = island.evolution.population();
+	const auto& weighted   = island.evolution.weightedPopulation();
+	for (size_t i = 0; i < island.outbox.size(); ++i)
+		island.outbox[i] = population[weighted[weighted.size() - 1 - i].first];
+
+	island.outboxState.store(FULL, std::memory_order_release);
+}
+
+void IslandModel::immigrate(size_t idx)
+{
+	Island& island = *m_islands[idx];
+	const size_t count = m_islands.size();
+
+	size_t sourceIdx = (idx + count - 1) % count;
+	if (m_config.topology == MigrationTopology::RANDOM)
+	{
+		sourceIdx = island.evolution.rng().uniform(count - 1);
+		if (sourceIdx >= idx)
+			++sourceIdx;
+	}
+	Island& source = *m_islands[sourceIdx];
+
+	int expected = FULL;
+	if (!source.outboxState.compare_exchange_strong(expected, READING, std::memory_order_acquire))
+		return;
+
+	// freshly bred population: elites sit at the front, immigrants replace offspring at the back
+	auto& population = island.evolution.population();
+	for (size_t i = 0; i < source.outbox.size(); ++i)
+		population[population.size() - 1 - i] = source.outbox[i];
+
+	source.outboxState.store(EMPTY, std::memory_order_release);
+	m_delivered.fetch_add(1, std::memory_order_relaxed);
+}
+
+const Genome& IslandModel::best() const
+{
+	const Evolution* best = nullptr;
+	for (const auto& island : m_islands)
+	{
+		if (!island->evolution.weightedPopulation().empty() && (!best || island->evolution.maxWeight() > best->maxWeight()))
+			best = &island->evolution;
+	}
+
+	if (!best)
+		throw std::runtime_error("IslandModel::best error: no island was evaluated");
+
+	return best->best();
+}
+
+int IslandModel::maxWeight() const
+{
+	int result = 0;
+	bool found = false;
+	for (const auto& island : m_islands)
+	{
+		if (island->evolution.weightedPopulation().empty())
+			continue;
+
+		result = found ? std::max(result, island->evolution.maxWeight()) : island->evolution.maxWeight();
+		found  = true;
+	}
+	return result;
+}
@@ -0,0 +1,294 @@
+#include "algorithm/metrics.h"
+#include "utility/bits.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+using namespace GeneticAlgorithm;
+
+// lowest bit of every byte
+static constexpr uint64_t g_byteLow	  = 0x0101010101010101ull;
+static constexpr uint64_t g_evenNotes = 0x0F0F0F0F0F0F0F0Full;
+
+// Lowest bit of every byte whose notes a (in x) and b (in y) are at most `step` apart.
+// The notes sit in the low half of the bytes; 64 + a + step - b stays within a byte, so no lane borrows
+// from the next one, and the difference is in range when that sum is in [64, 64 + 2 * step].
+static inline uint64_t closeNotes(uint64_t a, uint64_t b, uint64_t step)
+{
+	const uint64_t biased = ((a | (0x40 * g_byteLow)) + step * g_byteLow) - b;
+	const uint64_t upper  = biased + (63 - 2 * step) * g_byteLow;
+	return (biased >> 6) & ~(upper >> 7) & g_byteLow;
+}
+
+// bits of the first `count` notes of a word
+static inline uint64_t notesBelow(size_t count)
+{
+	return count >= Genome::NOTES_PER_WORD ? ~uint64_t{0} : (uint64_t{1} << (count * Genome::BITS_PER_NOTE)) - 1;
+}
+
+// mask of the nibble low bits belonging to notes [first, last) in word `idx`
+static inline uint64_t rangeMask(size_t idx, size_t first, size_t last)
+{
+	const size_t wordStart = idx * Genome::NOTES_PER_WORD;
+	const size_t lo		   = first > wordStart ? first - wordStart : 0;
+	const size_t hi		   = last > wordStart ? last - wordStart : 0;
+	return utility::NIBBLE_LOW & notesBelow(hi) & ~notesBelow(lo);
+}
+
+// mask of the nibble low bits belonging to notes in word `idx`
+static inline uint64_t noteMask(size_t idx, size_t notes)
+{
+	return rangeMask(idx, 0, notes);
+}
+
+// adds the counts of `added` and takes away those of `removed`; notes is left alone
+static void accumulate(NoteStats& stats, const NoteStats& added, const NoteStats& removed)
+{
+	stats.pauses += added.pauses - removed.pauses;
+	stats.continuations += added.continuations - removed.continuations;
+	stats.sounded += added.sounded - removed.sounded;
+	stats.triadTones += added.triadTones - removed.triadTones;
+	stats.pairs += added.pairs - removed.pairs;
+	stats.smoothPairs += added.smoothPairs - removed.smoothPairs;
+	stats.barNotes += added.barNotes - removed.barNotes;
+	stats.repeatedNotes += added.repeatedNotes - removed.repeatedNotes;
+}
+
+// METRIC_MAX when share hits target, falling linearly to 0 at the farthest possible share
+static int closeness(uint32_t count, uint32_t total, double target)
+{
+	if (total == 0)
+		return 0;
+
+	const double share	 = static_cast<double>(count) / total;
+	const double maxDiff = std::max(target, 1.0 - target);
+	return static_cast<int>(std::lround(METRIC_MAX * (1.0 - std::abs(share - target) / maxDiff)));
+}
+
+static int ratio(uint32_t count, uint32_t total)
+{
+	return total == 0 ? 0 : static_cast<int>((static_cast<uint64_t>(count) * METRIC_MAX) / total);
+}
+
+MelodyScorer::MelodyScorer(const Scale& scale, const MetricWeights& weights, const MetricParams& params) :
+	m_weights(weights),
+	m_params(params)
+{
+	if (m_params.maxStep > 13)
+		throw std::runtime_error("MelodyScorer error: maxStep is wider than the scale");
+
+	for (double weight : m_weights)
+	{
+		if (weight < 0.0)
+			throw std::runtime_error("MelodyScorer error: metric weights must not be negative");
+		m_totalWeight += weight;
+	}
+
+	if (m_totalWeight <= 0.0)
+		throw std::runtime_error("MelodyScorer error: no metric has a positive weight");
+
+	// codes 1 - 14 are the degrees of the scale over two octaves, the triad is built on degrees 1, 3 and 5
+	const auto scheme = scale.getScheme();
+	const int triad[] = {scheme[0] % 12, scheme[2] % 12, scheme[4] % 12};
+	for (uint64_t code = 1; code <= 14; ++code)
+	{
+		if (std::find(std::begin(triad), std::end(triad), scheme[code - 1] % 12) != std::end(triad))
+			m_triadCodes[m_triadCount++] = code * utility::NIBBLE_LOW;
+	}
+}
+
+NoteStats MelodyScorer::countNotes(const Genome& genome) const
+{
+	NoteStats stats = countNotes(genome, 0, genome.noteCount());
+	stats.notes		= static_cast<uint32_t>(genome.noteCount());
+	return stats;
+}
+
+NoteStats MelodyScorer::countNotes(const Genome& genome, size_t first, size_t last) const
+{
+	NoteStats stats;
+	const size_t notes = genome.noteCount();
+	last			   = std::min(last, notes);
+	if (first >= last)
+		return stats;
+
+	const size_t words	= Genome::wordsForBits(notes * Genome::BITS_PER_NOTE);
+	const uint64_t* data = genome.data();
+	const uint64_t step	 = m_params.maxStep;
+
+	// bits past the last whole note are cleared, so they read as pauses and are never counted as sounded
+	const auto load = [&](size_t w) { return data[w] & (noteMask(w, notes) * 0xF); };
+
+	const size_t lastWord = (last - 1) / Genome::NOTES_PER_WORD;
+	for (size_t w = first / Genome::NOTES_PER_WORD; w <= lastWord; ++w)
+	{
+		const uint64_t x	= load(w);
+		const uint64_t mask = rangeMask(w, first, last);
+
+		const uint64_t pauses		 = utility::zeroNibbles(x) & mask;
+		const uint64_t continuations = utility::zeroNibbles(~x) & mask;
+		const uint64_t sounded		 = ~(utility::zeroNibbles(x) | utility::zeroNibbles(~x)) & mask;
+
+		stats.pauses += utility::popcount(pauses);
+		stats.continuations += utility::popcount(continuations);
+		stats.sounded += utility::popcount(sounded);
+
+		uint64_t triad = 0;
+		for (size_t i = 0; i < m_triadCount; ++i)
+			triad |= utility::zeroNibbles(x ^ m_triadCodes[i]);
+		stats.triadTones += utility::popcount(triad & mask);
+
+		// y holds the note following each note of x
+		const uint64_t y		   = (x >> 4) | (w + 1 < words ? load(w + 1) << 60 : 0);
+		const uint64_t nextSounded = ~(utility::zeroNibbles(y) | utility::zeroNibbles(~y)) & utility::NIBBLE_LOW;
+		const uint64_t pairs	   = sounded & nextSounded;
+
+		const uint64_t close = closeNotes(x & g_evenNotes, y & g_evenNotes, step) |
+							   (closeNotes((x >> 4) & g_evenNotes, (y >> 4) & g_evenNotes, step) << 4);
+
+		stats.pairs += utility::popcount(pairs);
+		stats.smoothPairs += utility::popcount(pairs & close);
+
+		// z holds the note a bar before each note of x; the first bar of the genome has none
+		const uint64_t z	   = (x << Genome::BITS_PER_BAR) | (w > 0 ? load(w - 1) >> (Genome::BITS_PER_WORD - Genome::BITS_PER_BAR) : 0);
+		const uint64_t barMask = w > 0 ? mask : mask & ~notesBelow(Genome::NOTES_PER_BAR);
+
+		stats.barNotes += utility::popcount(barMask);
+		stats.repeatedNotes += utility::popcount(utility::zeroNibbles(x ^ z) & barMask);
+	}
+
+	return stats;
+}
+
+NoteStats MelodyScorer::updateNotes(const NoteStats& baseStats, const Genome& base, const Genome& genome, utility::Span<const NoteRange> changed) const
+{
+	if (base.noteCount() != genome.noteCount())
+		throw std::runtime_error("MelodyScorer::updateNotes error: genomes differ in length");
+
+	// the counts at note n read notes n, n + 1 and n - NOTES_PER_BAR, so changing notes [first, last)
+	// changes the counts at [first - 1, last + NOTES_PER_BAR); overlapping windows are recounted once
+	const auto windowStart = [](const NoteRange& range) { return range.first > 0 ? range.first - 1 : 0; };
+	const size_t notes	   = genome.noteCount();
+	size_t recounted	   = 0;
+	for (size_t i = 0; i < changed.size();)
+	{
+		const size_t first = windowStart(changed[i]);
+		size_t last		   = changed[i].last + Genome::NOTES_PER_BAR;
+		while (++i < changed.size() && windowStart(changed[i]) <= last)
+			last = std::max(last, changed[i].last + Genome::NOTES_PER_BAR);
+		recounted += std::min(last, notes) - std::min(first, notes);
+	}
+
+	// both genomes are recounted over the windows, past half the genome a full count is cheaper
+	if (2 * recounted >= notes)
+		return countNotes(genome);
+
+	NoteStats stats = baseStats;
+	for (size_t i = 0; i < changed.size();)
+	{
+		const size_t first = windowStart(changed[i]);
+		size_t last		   = changed[i].last + Genome::NOTES_PER_BAR;
+		while (++i < changed.size() && windowStart(changed[i]) <= last)
+			last = std::max(last, changed[i].last + Genome::NOTES_PER_BAR);
+
+		accumulate(stats, countNotes(genome, first, last), countNotes(base, first, last));
+	}
+	return stats;
+}
+
+int MelodyScorer::evaluate(const Genome& genome, void* state) const
+{
+	const NoteStats stats = countNotes(genome);
+	std::memcpy(state, &stats, sizeof(stats));
+	return score(stats);
+}
+
+int MelodyScorer::update(const Genome& base, const void* baseState, const Genome& genome, utility::Span<const NoteRange> changed, void* state) const
+{
+	NoteStats baseStats;
+	std::memcpy(&baseStats, baseState, sizeof(baseStats));
+
+	const NoteStats stats = updateNotes(baseStats, base, genome, changed);
+	std::memcpy(state, &stats, sizeof(stats));
+	return score(stats);
+}
+
+int MelodyScorer::metric(Metric metric, const NoteStats& stats) const
+{
+	switch (metric)
+	{
+		case Metric::SCALE_ADHERENCE:
+			return ratio(stats.triadTones, stats.sounded);
+		case Metric::SMOOTHNESS:
+			return ratio(stats.smoothPairs, stats.pairs);
+		case Metric::PAUSES:
+			return closeness(stats.pauses, stats.notes, m_params.pauseTarget);
+		case Metric::CONTINUATIONS:
+			return closeness(stats.continuations, stats.notes, m_params.continuationTarget);
+		case Metric::DENSITY:
+			return closeness(stats.sounded, stats.notes, m_params.densityTarget);
+		case Metric::REPETITION:
+			return closeness(stats.repeatedNotes, stats.barNotes, m_params.repetitionTarget);
+		default:
+			throw std::runtime_error("MelodyScorer::metric error: unknown metric");
+	}
+}
+
+int MelodyScorer::score(const NoteStats& stats) const
+{
+	double sum = 0.0;
+	for (size_t i = 0; i < m_weights.size(); ++i)
+	{
+		if (m_weights[i] > 0.0)
+			sum += m_weights[i] * metric(static_cast<Metric>(i), stats);
+	}
+	return static_cast<int>(std::lround(sum / m_totalWeight));
+}
+
+int MelodyScorer::score(const Genome& genome) const
+{
+	return score(countNotes(genome));
+}
+
+void MelodyScorer::score(utility::Span<const Genome> genomes, utility::Span<int> weights) const
+{
+	if (genomes.size() != weights.size())
+		throw std::runtime_error("MelodyScorer::score error: genomes and weights differ in size");
+
+	for (size_t i = 0; i < genomes.size(); ++i)
+		weights[i] = score(countNotes(genomes[i]));
+}
+
+void MelodyScorer::score(Metric metric, utility::Span<const Genome> genomes, utility::Span<int> weights) const
+{
+	if (genomes.size() != weights.size())
+		throw std::runtime_error("MelodyScorer::score error: genomes and weights differ in size");
+
+	for (size_t i = 0; i < genomes.size(); ++i)
+		weights[i] = this->metric(metric, countNotes(genomes[i]));
+}
+
+BatchFitnessFunc MelodyScorer::fitnessFunc() const
+{
+	return [scorer = *this](utility::Span<const Genome> genomes, utility::Span<int> weights) { scorer.score(genomes, weights); };
+}
+
+FitnessFunc MelodyScorer::genomeFitnessFunc() const
+{
+	return [scorer = *this](const Genome& genome) { return scorer.score(genome); };
+}
+
+MetricWeights MelodyScorer::uniformWeights()
+{
+	MetricWeights weights;
+	weights.fill(1.0);
+	return weights;
+}
+
+MetricWeights MelodyScorer::singleWeight(Metric metric)
+{
+	MetricWeights weights{};
+	weights[static_cast<size_t>(metric)] = 1.0;
+	return weights;
+}
@@ -0,0 +1,170 @@
+#include "algorithm/ngram.h"
+#include "utility/mapped_file.h"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+using namespace GeneticAlgorithm;
+
+static constexpr char g_magic[8]		 = {'O', 'M', 'G', 'N', 'G', 'R', 'A', 'M'};
+static constexpr uint32_t g_version		 = 1;
+static constexpr uint32_t g_byteOrderMark = 0x01020304;
+
+// file layout: this header, then the table of int16_t entries
+struct NGramFileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t order;
+	uint32_t byteOrder;
+	uint32_t logScale;
+	uint64_t entries;
+};
+static_assert(sizeof(NGramFileHeader) == 32, "the table must start right after the header");
+
+// Calls visit(ngram) for every n-gram of the genome, the index packed like the genome itself.
+template<typename Visit>
+static void forEachNGram(const Genome& genome, uint32_t order, Visit&& visit)
+{
+	const size_t notes = genome.noteCount();
+	if (notes < order)
+		return;
+
+	const size_t highShift = Genome::BITS_PER_NOTE * (size_t{order} - 1);
+	const uint64_t* words  = genome.data();
+
+	// the newest note enters at the top, the oldest leaves at the bottom
+	size_t ngram = 0;
+	for (size_t n = 0; n < notes; ++n)
+	{
+		const size_t code = (words[n / Genome::NOTES_PER_WORD] >> ((n % Genome::NOTES_PER_WORD) * Genome::BITS_PER_NOTE)) & 0xF;
+		ngram			  = (ngram >> 4) | (code << highShift);
+		if (n + 1 >= order)
+			visit(ngram);
+	}
+}
+
+NGramModel::NGramModel(uint32_t order, std::shared_ptr<const void> storage, const int16_t* table) :
+	m_order(order), m_storage(std::move(storage)), m_table(table)
+{
+}
+
+NGramModel NGramModel::train(utility::Span<const Genome> corpus, uint32_t order, double smoothing)
+{
+	if (order == 0 || order > MAX_ORDER)
+		throw std::runtime_error("NGramModel::train error: order must be between 1 and 5");
+
+	if (smoothing <= 0.0)
+		throw std::runtime_error("NGramModel::train error: smoothing must be positive");
+
+	const size_t size = size_t{1} << (4 * order);
+	std::vector<uint32_t> counts(size, 0);
+	for (const auto& genome : corpus)
+		forEachNGram(genome, order, [&](size_t ngram) { ++counts[ngram]; });
+
+	auto table = std::make_shared<std::vector<int16_t>>(size);
+
+	// the last note is the top nibble, so the 16 continuations of a context are `contexts` apart
+	const size_t contexts = size >> 4;
+	for (size_t context = 0; context < contexts; ++context)
+	{
+		uint64_t total = 0;
+		for (size_t next = 0; next < 16; ++next)
+			total += counts[context + next * contexts];
+
+		for (size_t next = 0; next < 16; ++next)
+		{
+			const size_t ngram		  = context + next * contexts;
+			const double probability  = (counts[ngram] + smoothing) / (static_cast<double>(total) + 16 * smoothing);
+			const double scaled		  = std::round(std::log2(probability) * LOG_SCALE);
+			(*table)[ngram]			  = static_cast<int16_t>(std::max<double>(scaled, std::numeric_limits<int16_t>::min()));
+		}
+	}
+
+	const int16_t* data = table->data();
+	return NGramModel(order, std::move(table), data);
+}
+
+NGramModel NGramModel::load(const std::string& path)
+{
+	auto file = std::make_shared<utility::MappedFile>(path, utility::FileAccess::RANDOM);
+
+	NGramFileHeader header;
+	if (file->size() < sizeof(header))
+		throw std::runtime_error("NGramModel::load error: " + path + " is not an n-gram model");
+	std::memcpy(&header, file->data(), sizeof(header));
+
+	if (std::memcmp(header.magic, g_magic, sizeof(g_magic)) != 0 || header.version != g_version)
+		throw std::runtime_error("NGramModel::load error: " + path + " is not an n-gram model");
+
+	if (header.byteOrder != g_byteOrderMark)
+		throw std::runtime_error("NGramModel::load error: " + path + " was written with another byte order");
+
+	if (header.order == 0 || header.order > MAX_ORDER || header.logScale != LOG_SCALE || header.entries != (uint64_t{1} << (4 * header.order)))
+		throw std::runtime_error("NGramModel::load error: " + path + " has an unsupported table");
+
+	if (file->size() != sizeof(header) + header.entries * sizeof(int16_t))
+		throw std::runtime_error("NGramModel::load error: " + path + " is truncated");
+
+	// the mapping is page aligned, so the table right after the 32-byte header is aligned too
+	const auto* table = reinterpret_cast<const int16_t*>(file->data() + sizeof(header));
+	return NGramModel(header.order, std::move(file), table);
+}
+
+void NGramModel::save(const std::string& path) const
+{
+	NGramFileHeader header;
+	std::memcpy(header.magic, g_magic, sizeof(g_magic));
+	header.version	 = g_version;
+	header.order	 = m_order;
+	header.byteOrder = g_byteOrderMark;
+	header.logScale	 = LOG_SCALE;
+	header.entries	 = tableSize();
+
+	std::ofstream modelFile(path, std::ios::binary);
+	modelFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	modelFile.write(reinterpret_cast<const char*>(m_table), static_cast<std::streamsize>(tableSize() * sizeof(int16_t)));
+
+	if (!modelFile)
+		throw std::runtime_error("NGramModel::save error: cannot write " + path);
+}
+
+int64_t NGramModel::logLikelihood(const Genome& genome) const
+{
+	int64_t sum = 0;
+	forEachNGram(genome, m_order, [&](size_t ngram) { sum += m_table[ngram]; });
+	return sum;
+}
+
+int NGramModel::score(const Genome& genome) const
+{
+	const size_t notes = genome.noteCount();
+	if (notes < m_order)
+		return 0;
+
+	const size_t ngrams	  = notes - m_order + 1;
+	const double meanLog2 = static_cast<double>(logLikelihood(genome)) / (LOG_SCALE * static_cast<double>(ngrams));
+	return static_cast<int>(std::lround(1000.0 * std::exp2(meanLog2)));
+}
+
+void NGramModel::score(utility::Span<const Genome> genomes, utility::Span<int> weights) const
+{
+	if (genomes.size() != weights.size())
+		throw std::runtime_error("NGramModel::score error: genomes and weights differ in size");
+
+	for (size_t i = 0; i < genomes.size(); ++i)
+		weights[i] = score(genomes[i]);
+}
+
+BatchFitnessFunc NGramModel::fitnessFunc() const
+{
+	return [model = *this](utility::Span<const Genome> genomes, utility::Span<int> weights) { model.score(genomes, weights); };
+}
+
+FitnessFunc NGramModel::genomeFitnessFunc() const
+{
+	return [model = *this](const Genome& genome) { return model.score(genome); };
+}
@@ -0,0 +1,67 @@
+#include "algorithm/note_events.h"
+#include "utility/bits.h"
+#include <stdexcept>
+
+using namespace GeneticAlgorithm;
+
+// notes of the genome in word w, past notes read as pauses
+static inline Genome::word_t noteWord(GenomeView genome, size_t w, size_t notes)
+{
+	const size_t first = w * Genome::NOTES_PER_WORD;
+	const Genome::word_t word = genome.word(w);
+	if (first + Genome::NOTES_PER_WORD <= notes)
+		return word;
+	return word & ((Genome::word_t{1} << ((notes - first) * Genome::BITS_PER_NOTE)) - 1);
+}
+
+void NoteEvents::decode(GenomeView genome, NoteEvents& events)
+{
+	const size_t notes = genome.noteCount();
+	if (notes > UINT32_MAX)
+		throw std::runtime_error("NoteEvents::decode error: genome has too many notes");
+
+	const size_t words = Genome::wordsForBits(notes * Genome::BITS_PER_NOTE);
+
+	// every code other than 0000 and 1111 starts a sound, so the arrays are sized before they are filled
+	size_t count = 0;
+	for (size_t w = 0; w < words; ++w)
+	{
+		const Genome::word_t x = noteWord(genome, w, notes);
+		count += utility::popcount(~(utility::zeroNibbles(x) | utility::zeroNibbles(~x)) & utility::NIBBLE_LOW);
+	}
+
+	events.degrees.resize(count);
+	events.starts.resize(count);
+	events.durations.resize(count);
+	events.length = static_cast<uint32_t>(notes);
+
+	uint8_t* degrees	= events.degrees.data();
+	uint32_t* starts	= events.starts.data();
+	uint32_t* durations = events.durations.data();
+
+	// slot of the sounding note, count while resting
+	size_t sounding = count;
+	size_t next		= 0;
+	for (size_t w = 0, n = 0; w < words; ++w)
+	{
+		Genome::word_t word = genome.word(w);
+		for (size_t i = 0; i < Genome::NOTES_PER_WORD && n < notes; ++i, ++n, word >>= Genome::BITS_PER_NOTE)
+		{
+			const auto code = static_cast<uint8_t>(word & 0xF);
+			if (code == 15)
+			{
+				if (sounding != count)
+					++durations[sounding];
+			}
+			else if (code == 0)
+				sounding = count;
+			else
+			{
+				degrees[next]	= code;
+				starts[next]	= static_cast<uint32_t>(n);
+				durations[next] = 1;
+				sounding		= next++;
+			}
+		}
+	}
+}
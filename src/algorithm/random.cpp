@@ -0,0 +1,109 @@
+#include "algorithm/random.h"
+#include <atomic>
+#include <random>
+
+using namespace GeneticAlgorithm;
+
+static uint64_t splitMix64(uint64_t& x)
+{
+	uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+	z		   = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z		   = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+static uint64_t initialSeed()
+{
+	std::random_device rand_dev;
+	return (static_cast<uint64_t>(rand_dev()) << 32) | rand_dev();
+}
+
+static std::atomic<uint64_t> g_masterSeed{initialSeed()};
+static std::atomic<uint64_t> g_seedEpoch{0};
+static std::atomic<uint64_t> g_threadCounter{0};
+
+Rng::Rng(uint64_t seed)
+{
+	for (auto& s : m_state)
+		s = splitMix64(seed);
+}
+
+Rng Rng::forStream(uint64_t seed, uint64_t stream)
+{
+	uint64_t mixed = stream;
+	return Rng(seed ^ splitMix64(mixed));
+}
+
+uint64_t Rng::uniform(uint64_t bound)
+{
+	// reject the low values that would bias the modulo
+	const uint64_t threshold = (0 - bound) % bound;
+	for (;;)
+	{
+		const uint64_t r = (*this)();
+		if (r >= threshold)
+			return r % bound;
+	}
+}
+
+void Rng::fillBits(uint64_t* words, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		words[i] = (*this)();
+}
+
+void Rng::jump()
+{
+	static constexpr uint64_t JUMP[] = {0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull, 0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull};
+
+	state_t s{};
+	for (const auto j : JUMP)
+	{
+		for (int b = 0; b < 64; ++b)
+		{
+			if (j & (uint64_t{1} << b))
+			{
+				for (size_t i = 0; i < s.size(); ++i)
+					s[i] ^= m_state[i];
+			}
+			(*this)();
+		}
+	}
+	m_state = s;
+}
+
+void Random::setMasterSeed(uint64_t seed)
+{
+	g_masterSeed.store(seed);
+	g_seedEpoch.fetch_add(1);
+	g_threadCounter.store(0);
+}
+
+uint64_t Random::masterSeed()
+{
+	return g_masterSeed.load();
+}
+
+Rng& Random::threadRng()
+{
+	struct ThreadState
+	{
+		Rng rng;
+		uint64_t epoch = ~uint64_t{0};
+	};
+	thread_local ThreadState state;
+
+	const uint64_t epoch = g_seedEpoch.load(std::memory_order_acquire);
+	if (state.epoch != epoch)
+	{
+		// thread streams are kept apart from genome streams by the top bit
+		state.rng	= Rng::forStream(masterSeed(), (uint64_t{1} << 63) | g_threadCounter.fetch_add(1));
+		state.epoch = epoch;
+	}
+	return state.rng;
+}
+
+Rng Random::streamRng(uint64_t stream)
+{
+	return Rng::forStream(masterSeed(), stream);
+}
@@ -0,0 +1,133 @@
+#include "algorithm/selection.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace GeneticAlgorithm;
+
+Selector::Selector(SelectionStrategy strategy, size_t tournamentSize) : m_strategy(strategy), m_tournamentSize(tournamentSize)
+{
+	if (m_tournamentSize == 0)
+		throw std::runtime_error("Selector error: tournament size must be positive");
+}
+
+void Selector::prepare(const WeightedPopulation& weightedPopulation)
+{
+	const size_t size = weightedPopulation.size();
+	if (size == 0)
+		throw std::runtime_error("Selector::prepare error: population is empty");
+
+	m_weights.resize(size);
+	m_totalWeight = 0;
+	for (const auto& [idx, weight] : weightedPopulation)
+	{
+		m_weights[idx] = weight;
+		m_totalWeight += static_cast<uint64_t>(std::max(weight, 0));
+	}
+
+	switch (m_strategy)
+	{
+		case SelectionStrategy::ALIAS:
+		{
+			m_probability.resize(size);
+			m_alias.resize(size);
+			m_small.clear();
+			m_large.clear();
+
+			// scaled so that the average column holds exactly 1
+			const double scale = m_totalWeight > 0 ? static_cast<double>(size) / static_cast<double>(m_totalWeight) : 0.0;
+			for (size_t i = 0; i < size; ++i)
+			{
+				m_probability[i] = m_totalWeight > 0 ? std::max(m_weights[i], 0) * scale : 1.0;
+				m_alias[i]		 = static_cast<uint32_t>(i);
+				(m_probability[i] < 1.0 ? m_small : m_large).push_back(static_cast<uint32_t>(i));
+			}
+
+			while (!m_small.empty() && !m_large.empty())
+			{
+				const uint32_t less = m_small.back();
+				const uint32_t more = m_large.back();
+				m_small.pop_back();
+
+				m_alias[less] = more;
+				m_probability[more] -= 1.0 - m_probability[less];
+				if (m_probability[more] < 1.0)
+				{
+					m_large.pop_back();
+					m_small.push_back(more);
+				}
+			}
+
+			// whatever is left is 1 up to rounding
+			for (const auto i : m_large)
+				m_probability[i] = 1.0;
+			for (const auto i : m_small)
+				m_probability[i] = 1.0;
+		}
+		break;
+		case SelectionStrategy::PREFIX_SUM:
+		{
+			m_prefix.resize(size);
+			uint64_t sum = 0;
+			for (size_t i = 0; i < size; ++i)
+			{
+				sum += static_cast<uint64_t>(std::max(m_weights[i], 0));
+				m_prefix[i] = sum;
+			}
+		}
+		break;
+		case SelectionStrategy::TOURNAMENT:
+		default:
+			break;
+	}
+}
+
+size_t Selector::select(Rng& rng) const
+{
+	switch (m_strategy)
+	{
+		case SelectionStrategy::ALIAS:
+			return selectAlias(rng);
+		case SelectionStrategy::PREFIX_SUM:
+			return selectPrefixSum(rng);
+		case SelectionStrategy::TOURNAMENT:
+		default:
+			return selectTournament(rng);
+	}
+}
+
+void Selector::selectPairs(size_t count, Rng& rng, ParentPairs& pairs) const
+{
+	pairs.resize(count);
+	for (auto& [first, second] : pairs)
+	{
+		first  = static_cast<uint32_t>(select(rng));
+		second = static_cast<uint32_t>(select(rng));
+	}
+}
+
+size_t Selector::selectAlias(Rng& rng) const
+{
+	const size_t column = rng.uniform(m_probability.size());
+	return rng.uniformReal() < m_probability[column] ? column : m_alias[column];
+}
+
+size_t Selector::selectPrefixSum(Rng& rng) const
+{
+	if (m_totalWeight == 0)
+		return rng.uniform(m_prefix.size());
+
+	const uint64_t target = rng.uniform(m_totalWeight);
+	return static_cast<size_t>(std::upper_bound(m_prefix.begin(), m_prefix.end(), target) - m_prefix.begin());
+}
+
+size_t Selector::selectTournament(Rng& rng) const
+{
+	size_t winner = rng.uniform(m_weights.size());
+	for (size_t round = 1; round < m_tournamentSize; ++round)
+	{
+		const size_t challenger = rng.uniform(m_weights.size());
+		if (m_weights[challenger] > m_weights[winner])
+			winner = challenger;
+	}
+	return winner;
+}
@@ -0,0 +1,114 @@
+#include "algorithm/telemetry.h"
+#include "utility/bits.h"
+#include <algorithm>
+
+using namespace GeneticAlgorithm;
+
+static constexpr uint64_t g_telemetrySeed = 0x7E1E'3E7B'0A5E'ED01;
+
+const char* GeneticAlgorithm::stageName(Stage stage)
+{
+	switch (stage)
+	{
+		case Stage::INIT:
+			return "init";
+		case Stage::EVALUATE:
+			return "evaluate";
+		case Stage::SELECT:
+			return "select";
+		case Stage::CROSSOVER:
+			return "crossover";
+		case Stage::MUTATE:
+			return "mutate";
+		case Stage::ENCODE:
+			return "encode";
+		default:
+			return "unknown";
+	}
+}
+
+Telemetry::Telemetry(Callback callback, size_t diversitySamples) :
+	m_callback(std::move(callback)), m_diversitySamples(diversitySamples), m_rng(g_telemetrySeed)
+{
+}
+
+void Telemetry::publish(uint64_t generation, uint64_t evaluations, const Population& population, const WeightedPopulation& weightedPopulation)
+{
+	GenerationStats stats;
+	stats.generation  = generation;
+	stats.evaluations = evaluations;
+
+	uint64_t nanos = 0;
+	for (size_t i = 0; i < STAGE_COUNT; ++i)
+	{
+		stats.stageNanos[i] = m_pending[i].exchange(0, std::memory_order_relaxed);
+		nanos += stats.stageNanos[i];
+	}
+
+	const uint64_t evaluateNanos = stats.stageNanos[static_cast<size_t>(Stage::EVALUATE)];
+	stats.evaluationsPerSec		 = evaluateNanos > 0 ? static_cast<double>(evaluations) * 1e9 / static_cast<double>(evaluateNanos) : 0.0;
+
+	// weighted population is in ascending order
+	if (!weightedPopulation.empty())
+	{
+		stats.worstFitness = weightedPopulation.front().second;
+		stats.bestFitness  = weightedPopulation.back().second;
+
+		int64_t sum = 0;
+		for (const auto& [_, weight] : weightedPopulation)
+			sum += weight;
+		stats.meanFitness = static_cast<double>(sum) / static_cast<double>(weightedPopulation.size());
+	}
+
+	stats.diversity = diversity(population, m_diversitySamples, m_rng);
+
+	m_totalEvaluations += evaluations;
+	m_totalNanos += nanos;
+	stats.totalEvaluations = m_totalEvaluations;
+	stats.totalNanos	   = m_totalNanos;
+
+	m_snapshot.store(stats);
+	if (m_callback)
+		m_callback(stats);
+}
+
+double Telemetry::diversity(const Population& population, size_t samples, Rng& rng)
+{
+	const size_t size = population.size();
+	if (size < 2 || population.front().empty())
+		return 0.0;
+
+	const auto distance = [&](size_t a, size_t b) {
+		const Genome& first	 = population[a];
+		const Genome& second = population[b];
+		const size_t words	 = std::min(first.wordCount(), second.wordCount());
+
+		uint64_t bits = 0;
+		for (size_t w = 0; w < words; ++w)
+			bits += utility::popcount(first.word(w) ^ second.word(w));
+		return bits;
+	};
+
+	uint64_t bits = 0;
+	size_t pairs  = 0;
+	if (size * (size - 1) / 2 <= samples)
+	{
+		for (size_t a = 0; a + 1 < size; ++a)
+		{
+			for (size_t b = a + 1; b < size; ++b, ++pairs)
+				bits += distance(a, b);
+		}
+	}
+	else
+	{
+		for (; pairs < samples; ++pairs)
+		{
+			const size_t a = rng.uniform(size);
+			// any genome but a
+			const size_t b = (a + 1 + rng.uniform(size - 1)) % size;
+			bits += distance(a, b);
+		}
+	}
+
+	return pairs > 0 ? static_cast<double>(bits) / (static_cast<double>(pairs) * static_cast<double>(population.front().size())) : 0.0;
+}
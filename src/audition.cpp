@@ -0,0 +1,141 @@
+#include "audition.h"
+#include <spdlog/spdlog.h>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace GeneticAlgorithm;
+
+static constexpr size_t g_ratingQueueSize = 64;
+
+AuditionPipeline::AuditionPipeline(Speaker& speaker, const MidiEncoder& encoder, PlayCallback onPlay, size_t lookahead) :
+	m_speaker(speaker),
+	m_encoder(encoder),
+	m_onPlay(std::move(onPlay)),
+	m_prepared(lookahead),
+	m_ratings(g_ratingQueueSize)
+{
+}
+
+void AuditionPipeline::prepare(utility::Span<const Genome> genomes)
+{
+	try
+	{
+		for (size_t i = 0; i < genomes.size(); ++i)
+		{
+			// the speaker keeps the bytes while the melody is loaded, so every melody gets its own buffer
+			MidiEncoder::Bytes midiBytes;
+			{
+				StageTimer timer(m_telemetry, Stage::ENCODE);
+				m_encoder.encodeGenomeToMidi(genomes[i], midiBytes);
+			}
+			Mix_Music* music = m_speaker.loadMidiBytes(std::move(midiBytes));
+
+			if (!m_prepared.push(Prepared{i, music}))
+			{
+				m_speaker.freeMusic(music);
+				break;
+			}
+		}
+	}
+	catch (...)
+	{
+		m_prepareError = std::current_exception();
+	}
+	m_prepared.close();
+}
+
+void AuditionPipeline::evaluate(utility::Span<const Genome> genomes, utility::Span<int> weights)
+{
+	m_prepared.reset();
+	m_ratings.reset();
+	m_prepareError = nullptr;
+
+	// checked after the reset, so a cancel() racing with it still leaves the queues closed or is seen here
+	if (m_cancelled.load())
+		throw std::runtime_error("AuditionPipeline::evaluate error: auditions were cancelled");
+
+	std::thread producer(&AuditionPipeline::prepare, this, genomes);
+
+	std::vector<bool> rated(genomes.size(), false);
+	Mix_Music* playing = nullptr;
+	std::exception_ptr error;
+
+	try
+	{
+		for (size_t n = 0; n < genomes.size(); ++n)
+		{
+			auto item = m_prepared.pop();
+			if (!item)
+				break;
+			if (m_cancelled.load())
+			{
+				m_speaker.freeMusic(item->music);
+				break;
+			}
+
+			m_speaker.playMusic(item->music);
+			m_speaker.freeMusic(playing);
+			playing = item->music;
+
+			if (m_onPlay)
+				m_onPlay(item->index);
+
+			// ratings may arrive for any melody of the batch, wait for the one playing
+			while (!rated[item->index])
+			{
+				auto rating = m_ratings.pop();
+				if (!rating)
+					break;
+
+				if (rating->index < genomes.size())
+				{
+					weights[rating->index] = rating->weight;
+					rated[rating->index]   = true;
+				}
+			}
+
+			// the ratings queue only closes on cancel()
+			if (!rated[item->index])
+				break;
+		}
+	}
+	catch (...)
+	{
+		error = std::current_exception();
+	}
+
+	m_prepared.close();
+	producer.join();
+
+	// melodies prepared but never played
+	while (auto item = m_prepared.pop())
+		m_speaker.freeMusic(item->music);
+	m_speaker.freeMusic(playing);
+
+	if (error)
+		std::rethrow_exception(error);
+	if (m_prepareError)
+		std::rethrow_exception(m_prepareError);
+	if (m_cancelled.load())
+		throw std::runtime_error("AuditionPipeline::evaluate error: auditions were cancelled");
+
+	spdlog::info("Auditions finished: {} melodies rated", genomes.size());
+}
+
+BatchFitnessFunc AuditionPipeline::fitnessFunc()
+{
+	return [this](utility::Span<const Genome> genomes, utility::Span<int> weights) { evaluate(genomes, weights); };
+}
+
+void AuditionPipeline::submitRating(size_t index, int weight)
+{
+	m_ratings.push(Rating{index, weight});
+}
+
+void AuditionPipeline::cancel()
+{
+	m_cancelled.store(true);
+	m_ratings.close();
+	m_prepared.close();
+}
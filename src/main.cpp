@@ -1,8 +1,13 @@
 #include "speaker.h"
 #include "midi.h"
+#include "midi_decoder.h"
+#include "audition.h"
+#include "synth.h"
+#include "algorithm/metrics.h"
+#include "algorithm/ngram.h"
 #include "utility/logger.h"
 #include "version.h"
-#include "algorithm/genetic.h"
+#include "algorithm/evolution.h"
 #include <iostream>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_mixer.h>
@@ -14,7 +19,7 @@
 using namespace GeneticAlgorithm;
 
 std::vector<spdlog::sink_ptr> setupLogger(std::string path);
-int fitnessFunc(Genome genome);
+int fitnessFunc(const Genome& genome);
 
 int main() {
 
@@ -41,9 +46,25 @@ int main() {
     //Scale scale(ScaleType::MINOR_BLUES, "C");
     //MidiEncoder midiEncoder(scale, 130);
 
-    //auto pop = Genetic::runEvolution(fitnessFunc, 5, 10);
-
-    //midiEncoder.encodeGenomeToMidi(pop[0], "untitled.mid");
+    //Evolution evolution;
+    //AuditionPipeline auditions(*speaker, midiEncoder, [&](size_t idx) {
+    //    auditions.submitRating(idx, fitnessFunc(evolution.population()[idx]));
+    //});
+    //evolution.run(auditions.fitnessFunc(), 5, 10);
+    // or let the built-in metrics rate the melodies
+    //evolution.run(MelodyScorer(scale).fitnessFunc(), 900, 1000);
+    // or rate them by how much they resemble a MIDI corpus
+    //Population corpus;
+    //MidiDecoder(scale).decodeCorpus({"corpus/a.mid", "corpus/b.mid"}, corpus);
+    //NGramModel::train(corpus, 4).save("corpus.ngram");
+    //evolution.run(NGramModel::load("corpus.ngram").fitnessFunc(), 900, 1000);
+
+    //midiEncoder.encodeGenomeToMidi(evolution.best(), "untitled.mid");
+
+    // or skip MIDI and let the built-in synthesizer play / render it
+    //Synthesizer synth(scale);
+    //speaker->playMelody(synth, evolution.best());
+    //synth.renderToWav(evolution.best(), "untitled.wav");
 
     //spdlog::info("Midi encoded to file");
     //std::this_thread::sleep_for(std::chrono::seconds(3));
@@ -59,6 +80,7 @@ int main() {
     std::this_thread::sleep_for(std::chrono::seconds(3));
 
     SDL_Quit();
+    utility::shutdownLogger();
 
     return 0;
 }
@@ -69,14 +91,19 @@ std::vector<spdlog::sink_ptr> setupLogger(std::string path)
     sinks.push_back(std::make_shared<spdlog::sinks::stderr_sink_mt>());
     sinks.push_back(std::make_shared<spdlog::sinks::daily_file_sink_mt>(path, 23, 59));
 
-    auto logger = utility::setupLogger(sinks);
+    // async, so logging never stalls the evolution on file I/O
+    utility::LoggerConfig config;
+    config.mode = utility::LogMode::ASYNC;
+    config.overflow = utility::LogOverflow::OVERRUN_OLDEST;
+
+    auto logger = utility::setupLogger(sinks, config);
     auto lvl = spdlog::level::level_enum::debug;
     spdlog::set_level(lvl);
 
     return sinks;
 }
 
-int fitnessFunc(Genome genome)
+int fitnessFunc(const Genome& genome)
 {
     int res;
     std::cout << "Enter the number: ";
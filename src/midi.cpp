@@ -1,114 +1,278 @@
 #include "midi.h"
+#include "algorithm/note_events.h"
+#include "utility/thread_pool.h"
+#include <cstring>
 #include <fstream>
-#include <sstream>
-#include <array>
-#include <bitset>
+#include <stdexcept>
 #include <spdlog/spdlog.h>
 
 using namespace GeneticAlgorithm;
 
 static constexpr unsigned char defaultVelocity = 0x64; // default velocity of a note
+static constexpr unsigned char releaseVelocity = 0x40;
 
-static constexpr std::array<unsigned char, 34> g_headerPartAfterTempo = {
-	0xe2, 0x00, 0xff, 0x58,
-	0x04, 0x04, 0x02, 0x18, 0x08, 0x00, 0xff, 0x2f,
-	0x00, 0x4d, 0x54, 0x72, 0x6b, 0x00,
-	0x00, 0x01,	0x11, // num of bytes
-	0x00, 0xff, 0x03, 0x09, 0x53, 0x61, 0x6d,
-	0x70, 0x6c, 0x65, 0x72, 0x20, 0x31
+static constexpr uint32_t g_ticksPerQuarter = 0x60;
+static constexpr uint32_t g_ticksPerNote	= g_ticksPerQuarter;
+// largest delta time a variable-length quantity can hold
+static constexpr uint32_t g_maxDelta = 0x0FFFFFFF;
+
+static constexpr size_t g_fileHeaderSize  = 14;
+static constexpr size_t g_chunkHeaderSize = 8;
+// delta time of up to 4 bytes + event
+static constexpr size_t g_maxEventSize = 4 + 3;
+// track name meta event: delta, ff 03, length, "Sampler " + up to 20 digits
+static constexpr size_t g_maxTrackNameSize = 4 + 8 + 20;
+
+// tempo track: tempo (its 3 bytes are filled in), time signature 4/4 and end of track
+static constexpr std::array<unsigned char, 19> g_tempoTrack = {
+	0x00, 0xff, 0x51, 0x03, 0x00, 0x00, 0x00,
+	0x00, 0xff, 0x58, 0x04, 0x04, 0x02, 0x18, 0x08,
+	0x00, 0xff, 0x2f, 0x00
 };
+static constexpr size_t g_tempoOffset = 4;
+// slower tempos need more microseconds per quarter than the 3 tempo bytes hold
+static constexpr uint8_t g_minTempo = 4;
+
+static constexpr std::array<unsigned char, 3> g_endOfTrack = { 0xff, 0x2f, 0x00 };
+
+static unsigned char* writeBytes(unsigned char* out, const unsigned char* bytes, size_t count)
+{
+	std::memcpy(out, bytes, count);
+	return out + count;
+}
+
+static unsigned char* writeUint32(unsigned char* out, uint32_t value)
+{
+	out[0] = static_cast<unsigned char>(value >> 24);
+	out[1] = static_cast<unsigned char>(value >> 16);
+	out[2] = static_cast<unsigned char>(value >> 8);
+	out[3] = static_cast<unsigned char>(value);
+	return out + 4;
+}
+
+// variable-length quantity, 7 bits per byte, most significant first
+static unsigned char* writeDelta(unsigned char* out, uint32_t delta)
+{
+	if (delta < 0x80)
+	{
+		*out = static_cast<unsigned char>(delta);
+		return out + 1;
+	}
+
+	unsigned char buffer[4];
+	size_t count = 0;
+	do
+	{
+		buffer[count++] = delta & 0x7F;
+		delta >>= 7;
+	} while (delta != 0);
+
+	while (count > 1)
+		*out++ = buffer[--count] | 0x80;
+	*out++ = buffer[0];
+	return out;
+}
+
+static unsigned char* writeEvent(unsigned char* out, uint32_t delta, const std::array<unsigned char, 3>& event, unsigned char channel)
+{
+	out	   = writeDelta(out, delta);
+	out[0] = event[0] | channel;
+	out[1] = event[1];
+	out[2] = event[2];
+	return out + 3;
+}
 
-static constexpr std::array<unsigned char, 4> g_tailPart = { 0x00, 0xFF, 0x2F, 0x00 };
+// every note emits at most a note off and a note on; the last note off and end of track follow
+static size_t maxEventsSize(size_t notes)
+{
+	return (notes + 1) * 2 * g_maxEventSize;
+}
 
-static std::vector<unsigned char> decimalTempoToBytes(uint8_t tempo)
+static size_t maxTrackSize(size_t notes)
 {
-	std::vector<unsigned char> arrayOfBytes(3);
+	return g_chunkHeaderSize + g_maxTrackNameSize + maxEventsSize(notes);
+}
 
-	for (int i = 0; i < 3; i++)
-		arrayOfBytes[2 - i] = (tempo >> (i * 8));
+static size_t maxFileSize(utility::Span<const Genome> genomes)
+{
+	size_t size = g_fileHeaderSize + g_chunkHeaderSize + g_tempoTrack.size();
+	for (const auto& genome : genomes)
+		size += maxTrackSize(genome.noteCount());
+	return size;
+}
 
-	return arrayOfBytes;
+// melodies of a population get their own channel, skipping the percussion channel 10
+static unsigned char trackChannel(size_t track)
+{
+	const auto channel = static_cast<unsigned char>(track % 15);
+	return channel < 9 ? channel : channel + 1;
 }
 
-MidiEncoder::MidiEncoder(Scale scale, uint8_t tempo) : m_scale(scale), m_tempoBytes(decimalTempoToBytes(tempo))
+static void writeFile(const std::string& path, const MidiEncoder::Bytes& bytes)
 {
+	std::ofstream midiFile(path, std::ios::binary);
+	midiFile.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+	if (!midiFile)
+		throw std::runtime_error("MidiEncoder error: cannot write " + path);
 }
 
-void MidiEncoder::writeGenomeToMidiBytes(const Genome& genome, std::vector<unsigned char>& midiBytes)
+MidiEncoder::MidiEncoder(Scale scale, uint8_t tempo) : m_scale(scale), m_events{}
 {
-	std::bitset<4> note{};
-	uint8_t prevIdx{0};
-	unsigned char velocity;
-	auto scale = m_scale.getScale();
+	if (tempo == 0)
+		throw std::runtime_error("MidiEncoder error: tempo must be positive");
+	if (tempo < g_minTempo)
+		throw std::runtime_error("MidiEncoder error: tempo must be at least 4 quarter notes per minute");
 
-	size_t i = 0;
-	size_t j = 0;
+	const uint32_t microsecondsPerQuarter = 60000000u / tempo;
+	for (size_t i = 0; i < 3; i++)
+		m_tempoBytes[2 - i] = static_cast<unsigned char>(microsecondsPerQuarter >> (i * 8));
 
-	for (const auto& bit : genome)
+	const auto keys = m_scale.getScale();
+	for (size_t code = 1; code <= keys.size(); ++code)
 	{
-		note[i] = bit;
-		i = (i + 1) % 4;
-		if (i == 0)
-		{
-			velocity = defaultVelocity;
-			auto idx = note.to_ulong();
-
-			if (idx == 0)
-			{
-				velocity = 0x00;
-				idx = prevIdx;
-			}
-
-			if (idx == 15 && prevIdx != 0)
-			{
-				if (prevIdx != 0)
-					idx = prevIdx;
-				else
-					idx = 1; // root note
-			}
-
-			// note on
-			midiBytes.push_back(0x00);
-			midiBytes.push_back(0x90);
-			midiBytes.push_back(scale.at(idx - 1));
-			midiBytes.push_back(velocity); // loudness of a note 13+8*64+4
-
-			// note off
-			midiBytes.push_back(0x60);
-			midiBytes.push_back(0x80);
-			midiBytes.push_back(scale.at(idx - 1));
-			midiBytes.push_back(0x40);
-
-			prevIdx = idx;
-		}
+		m_events[code].on  = {0x90, keys[code - 1], defaultVelocity};
+		m_events[code].off = {0x80, keys[code - 1], releaseVelocity};
 	}
 }
 
+unsigned char* MidiEncoder::writeHeader(unsigned char* out, size_t tracks) const
+{
+	if (tracks > 0xFFFF)
+		throw std::runtime_error("MidiEncoder error: a MIDI file holds at most 65535 tracks");
+
+	const unsigned char header[] = {
+		'M', 'T', 'h', 'd', 0x00, 0x00, 0x00, 0x06,
+		0x00, 0x01, // format 1: simultaneous tracks
+		static_cast<unsigned char>(tracks >> 8), static_cast<unsigned char>(tracks),
+		0x00, static_cast<unsigned char>(g_ticksPerQuarter)
+	};
+	out = writeBytes(out, header, sizeof(header));
+
+	const unsigned char chunk[] = {'M', 'T', 'r', 'k'};
+	out = writeBytes(out, chunk, sizeof(chunk));
+	out = writeUint32(out, static_cast<uint32_t>(g_tempoTrack.size()));
+
+	unsigned char* tempoTrack = out;
+	out = writeBytes(out, g_tempoTrack.data(), g_tempoTrack.size());
+	std::memcpy(tempoTrack + g_tempoOffset, m_tempoBytes.data(), m_tempoBytes.size());
+	return out;
+}
+
+unsigned char* MidiEncoder::writeTrack(unsigned char* out, const Genome& genome, size_t track) const
+{
+	const unsigned char chunk[] = {'M', 'T', 'r', 'k'};
+	out = writeBytes(out, chunk, sizeof(chunk));
+
+	// length is known once the events are written
+	unsigned char* length = out;
+	out += 4;
+	unsigned char* start = out;
+
+	const std::string name = "Sampler " + std::to_string(track + 1);
+	const unsigned char nameEvent[] = {0x00, 0xff, 0x03, static_cast<unsigned char>(name.size())};
+	out = writeBytes(out, nameEvent, sizeof(nameEvent));
+	out = writeBytes(out, reinterpret_cast<const unsigned char*>(name.data()), name.size());
+
+	// trailing rests still take their time
+	uint32_t delta = 0;
+	out = writeEvents(out, genome, trackChannel(track), delta);
+	out = writeDelta(out, delta);
+	out = writeBytes(out, g_endOfTrack.data(), g_endOfTrack.size());
+
+	writeUint32(length, static_cast<uint32_t>(out - start));
+	return out;
+}
+
+unsigned char* MidiEncoder::writeEvents(unsigned char* out, const Genome& genome, unsigned char channel, uint32_t& trailingDelta) const
+{
+	const size_t notes = genome.noteCount();
+	if (notes * g_ticksPerNote > g_maxDelta)
+		throw std::runtime_error("MidiEncoder error: genome is too long for a MIDI track");
+
+	const NoteEvents& events = genome.noteEvents();
+
+	// note the previous sound ended at
+	uint32_t cursor = 0;
+	for (size_t i = 0; i < events.size(); ++i)
+	{
+		const auto& event = m_events[events.degrees[i]];
+		out	   = writeEvent(out, (events.starts[i] - cursor) * g_ticksPerNote, event.on, channel);
+		out	   = writeEvent(out, events.durations[i] * g_ticksPerNote, event.off, channel);
+		cursor = events.starts[i] + events.durations[i];
+	}
+
+	trailingDelta = (events.length - cursor) * g_ticksPerNote;
+	return out;
+}
+
+void MidiEncoder::writeGenomeToMidiBytes(const Genome& genome, Bytes& midiBytes) const
+{
+	const size_t size = midiBytes.size();
+	midiBytes.resize(size + maxEventsSize(genome.noteCount()));
+
+	uint32_t delta	   = 0;
+	unsigned char* end = writeEvents(midiBytes.data() + size, genome, 0, delta);
+	midiBytes.resize(static_cast<size_t>(end - midiBytes.data()));
+}
+
+void MidiEncoder::encodeGenomeToMidi(const Genome& genome, Bytes& midiBytes) const
+{
+	midiBytes.resize(g_fileHeaderSize + g_chunkHeaderSize + g_tempoTrack.size() + maxTrackSize(genome.noteCount()));
+
+	unsigned char* out = writeHeader(midiBytes.data(), 2);
+	out = writeTrack(out, genome, 0);
+	midiBytes.resize(static_cast<size_t>(out - midiBytes.data()));
+}
+
 void MidiEncoder::encodeGenomeToMidi(const Genome& genome, const std::string& path)
 {
-	// write tempo
-	/*for (const auto& byte : m_tempoBytes)
-		m_midiBytes.push_back(byte);*/
-	m_midiBytes.push_back(0x03);
-	m_midiBytes.push_back(0x07);
-	m_midiBytes.push_back(0x0a);
+	encodeGenomeToMidi(genome, m_midiBytes);
+	writeFile(path, m_midiBytes);
+}
 
-	// writing the part after tempo
-	for (const auto& byte : g_headerPartAfterTempo)
-		m_midiBytes.push_back(byte);
+void MidiEncoder::encodeGenomesToMidi(utility::Span<const Genome> genomes, utility::Span<const std::string> paths)
+{
+	if (genomes.size() != paths.size())
+		throw std::runtime_error("MidiEncoder::encodeGenomesToMidi error: genomes and paths differ in size");
 
-	// writing genome part
-	writeGenomeToMidiBytes(genome, m_midiBytes);
+	for (size_t i = 0; i < genomes.size(); ++i)
+	{
+		encodeGenomeToMidi(genomes[i], m_midiBytes);
+		writeFile(paths[i], m_midiBytes);
+	}
+}
 
-	// writing the tail
-	for (const auto& byte : g_tailPart)
-		m_midiBytes.push_back(byte);
+void MidiEncoder::encodeGenomesToMidi(utility::Span<const Genome> genomes, std::vector<Bytes>& files, utility::ThreadPool* pool) const
+{
+	files.resize(genomes.size());
 
-	//Writing to midi file
-	std::ofstream midiFile;
-	midiFile.open(path, std::ios::binary);
+	auto encode = [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+			encodeGenomeToMidi(genomes[i], files[i]);
+	};
 
-	midiFile.write(reinterpret_cast<const char*>(&m_midiBytes[0]), m_midiBytes.size() * sizeof(unsigned char));
+	if (pool)
+		pool->parallelFor(genomes.size(), encode);
+	else
+		encode(0, genomes.size());
+}
 
-	midiFile.close();
-}
\ No newline at end of file
+void MidiEncoder::encodePopulationToMidi(utility::Span<const Genome> genomes, Bytes& midiBytes) const
+{
+	midiBytes.resize(maxFileSize(genomes));
+
+	unsigned char* out = writeHeader(midiBytes.data(), genomes.size() + 1);
+	for (size_t i = 0; i < genomes.size(); ++i)
+		out = writeTrack(out, genomes[i], i);
+
+	midiBytes.resize(static_cast<size_t>(out - midiBytes.data()));
+}
+
+void MidiEncoder::encodePopulationToMidi(utility::Span<const Genome> genomes, const std::string& path)
+{
+	encodePopulationToMidi(genomes, m_midiBytes);
+	writeFile(path, m_midiBytes);
+
+	spdlog::info("{} melodies written to {}", genomes.size(), path);
+}
@@ -0,0 +1,378 @@
+#include "midi_decoder.h"
+#include "utility/mapped_file.h"
+#include "utility/thread_pool.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <spdlog/spdlog.h>
+
+using namespace GeneticAlgorithm;
+
+static constexpr uint8_t g_pause		= 0x0;
+static constexpr uint8_t g_continuation = 0xF;
+static constexpr uint8_t g_percussion	= 9; // channel 10
+static constexpr uint64_t g_held		= std::numeric_limits<uint64_t>::max();
+
+namespace
+{
+// bounds-checked reading of a chunk
+class Cursor
+{
+public:
+	Cursor(const unsigned char* data, size_t size) : m_pos(data), m_end(data + size) {}
+
+	bool atEnd() const { return m_pos >= m_end; };
+	const unsigned char* position() const { return m_pos; };
+
+	uint8_t peek() const
+	{
+		require(1);
+		return *m_pos;
+	};
+
+	uint8_t byte()
+	{
+		require(1);
+		return *m_pos++;
+	};
+
+	uint32_t uint32()
+	{
+		require(4);
+		const uint32_t value = (uint32_t{m_pos[0]} << 24) | (uint32_t{m_pos[1]} << 16) | (uint32_t{m_pos[2]} << 8) | m_pos[3];
+		m_pos += 4;
+		return value;
+	};
+
+	uint16_t uint16()
+	{
+		require(2);
+		const uint16_t value = static_cast<uint16_t>((m_pos[0] << 8) | m_pos[1]);
+		m_pos += 2;
+		return value;
+	};
+
+	// variable-length quantity of at most 4 bytes
+	uint32_t varLen()
+	{
+		uint32_t value = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			const uint8_t b = byte();
+			value			= (value << 7) | (b & 0x7F);
+			if ((b & 0x80) == 0)
+				return value;
+		}
+		throw std::runtime_error("MidiDecoder error: variable-length quantity longer than 4 bytes");
+	};
+
+	void skip(size_t count)
+	{
+		require(count);
+		m_pos += count;
+	};
+
+private:
+	void require(size_t count) const
+	{
+		if (static_cast<size_t>(m_end - m_pos) < count)
+			throw std::runtime_error("MidiDecoder error: unexpected end of data");
+	};
+
+	const unsigned char* m_pos;
+	const unsigned char* m_end;
+};
+}
+
+// Collects the notes of one track slot by slot and emits a genome whenever a window is complete.
+class MidiDecoder::TrackReader
+{
+public:
+	TrackReader(const MidiDecoderConfig& config, Population& genomes) :
+		m_windowNotes(config.genomeLength / Genome::BITS_PER_NOTE), m_slice(config.sliceTracks), m_genomes(genomes)
+	{
+	}
+
+	// no more notes are wanted from this track
+	bool done() const { return m_done; };
+
+	void noteOn(uint64_t slot, uint8_t code, uint8_t pitch)
+	{
+		if (m_done)
+			return;
+
+		if (slot < m_filled)
+		{
+			// another note starting in the same slot, the highest one wins
+			if (pitch > m_pitch && slot - m_windowStart < m_codes.size())
+			{
+				m_codes[slot - m_windowStart] = code;
+				m_code		= code;
+				m_pitch		= pitch;
+				m_holdUntil = g_held;
+			}
+			return;
+		}
+
+		fillTo(slot);
+		m_code		= code;
+		m_pitch		= pitch;
+		m_holdUntil = g_held;
+		put(code);
+	}
+
+	void noteOff(uint64_t slot, uint8_t pitch)
+	{
+		if (m_holdUntil == g_held && pitch == m_pitch)
+			m_holdUntil = std::max(slot, m_filled);
+	}
+
+	// endSlot: slot of the end of track, where a note never released stops
+	void finish(uint64_t endSlot)
+	{
+		if (m_code != g_pause)
+			fillTo(m_holdUntil == g_held ? std::max(endSlot, m_filled) : m_holdUntil);
+
+		if (!m_done)
+			emit();
+	}
+
+private:
+	// fills the slots before `slot` with what sounds there
+	void fillTo(uint64_t slot)
+	{
+		while (m_filled < slot && !m_done)
+			put(m_code != g_pause && m_filled < m_holdUntil ? g_continuation : g_pause);
+	}
+
+	void put(uint8_t code)
+	{
+		// a window starting in the middle of a note strikes it again
+		if (m_codes.empty() && code == g_continuation)
+			code = m_code;
+
+		m_codes.push_back(code);
+		m_hasNotes = m_hasNotes || (code != g_pause && code != g_continuation);
+		++m_filled;
+
+		if (m_windowNotes != 0 && m_codes.size() == m_windowNotes)
+		{
+			emit();
+			m_done = !m_slice;
+		}
+	}
+
+	void emit()
+	{
+		if (m_hasNotes)
+		{
+			const size_t notes = m_windowNotes != 0 ? m_windowNotes : m_codes.size();
+			Genome genome(notes * Genome::BITS_PER_NOTE);
+			for (size_t i = 0; i < m_codes.size(); ++i)
+			{
+				if (m_codes[i] != g_pause)
+					genome.setNibble(i, m_codes[i]);
+			}
+			m_genomes.push_back(std::move(genome));
+		}
+
+		m_windowStart = m_filled;
+		m_codes.clear();
+		m_hasNotes = false;
+	}
+
+	size_t m_windowNotes;
+	bool m_slice;
+	Population& m_genomes;
+
+	std::vector<uint8_t> m_codes; // slots of the current window
+	uint64_t m_windowStart{0};
+	uint64_t m_filled{0}; // slots written so far
+	bool m_hasNotes{false};
+	bool m_done{false};
+
+	// last note started: its code, pitch and the slot it is held until
+	uint8_t m_code{g_pause};
+	uint8_t m_pitch{0};
+	uint64_t m_holdUntil{g_held};
+};
+
+MidiDecoder::MidiDecoder(const Scale& scale, const MidiDecoderConfig& config) : m_config(config)
+{
+	if (m_config.genomeLength % Genome::BITS_PER_NOTE != 0)
+		throw std::runtime_error("MidiDecoder error: genome length must be a multiple of 4");
+
+	if (m_config.notesPerQuarter == 0)
+		throw std::runtime_error("MidiDecoder error: notes per quarter must be positive");
+
+	// nearest of the 14 keys, pitches outside the two octaves are moved into them by octaves
+	const auto keys = scale.getScale();
+	for (int pitch = 0; pitch < 128; ++pitch)
+	{
+		int folded = pitch;
+		while (folded < keys.front())
+			folded += 12;
+		while (folded > keys.back())
+			folded -= 12;
+
+		size_t nearest = 0;
+		for (size_t i = 1; i < keys.size(); ++i)
+		{
+			if (std::abs(keys[i] - folded) < std::abs(keys[nearest] - folded))
+				nearest = i;
+		}
+		m_codes[static_cast<size_t>(pitch)] = static_cast<uint8_t>(nearest + 1);
+	}
+}
+
+void MidiDecoder::decodeFile(const std::string& path, Population& genomes) const
+{
+	const utility::MappedFile file(path);
+	decode(file.data(), file.size(), genomes);
+}
+
+void MidiDecoder::decode(const unsigned char* data, size_t size, Population& genomes) const
+{
+	Cursor file(data, size);
+
+	if (size < 14 || std::memcmp(data, "MThd", 4) != 0)
+		throw std::runtime_error("MidiDecoder error: not a standard MIDI file");
+	file.skip(4);
+
+	const uint32_t headerSize = file.uint32();
+	if (headerSize < 6)
+		throw std::runtime_error("MidiDecoder error: header chunk is too short");
+
+	file.uint16(); // format, tracks are read the same way in all of them
+	const uint16_t tracks	= file.uint16();
+	const uint16_t division = file.uint16();
+	file.skip(headerSize - 6);
+
+	if (division & 0x8000)
+		throw std::runtime_error("MidiDecoder error: SMPTE time division is not supported");
+
+	const uint32_t slotTicks = division / m_config.notesPerQuarter;
+	if (slotTicks == 0)
+		throw std::runtime_error("MidiDecoder error: time division is finer than a genome note");
+
+	for (uint16_t track = 0; track < tracks && !file.atEnd();)
+	{
+		const unsigned char* id = file.position();
+		file.skip(4);
+		const uint32_t length = file.uint32();
+		const unsigned char* chunk = file.position();
+		file.skip(length);
+
+		// unknown chunks are skipped as the standard asks
+		if (std::memcmp(id, "MTrk", 4) == 0)
+		{
+			decodeTrack(chunk, length, slotTicks, genomes);
+			++track;
+		}
+	}
+}
+
+void MidiDecoder::decodeTrack(const unsigned char* data, size_t size, uint32_t slotTicks, Population& genomes) const
+{
+	Cursor track(data, size);
+	TrackReader reader(m_config, genomes);
+
+	const auto slot = [slotTicks](uint64_t tick) { return (tick + slotTicks / 2) / slotTicks; };
+
+	uint64_t tick  = 0;
+	uint8_t status = 0;
+	while (!track.atEnd() && !reader.done())
+	{
+		tick += track.varLen();
+
+		if (track.peek() & 0x80)
+			status = track.byte();
+		else if (status == 0)
+			throw std::runtime_error("MidiDecoder error: running status without a status byte");
+
+		if (status == 0xFF)
+		{
+			const uint8_t type = track.byte();
+			track.skip(track.varLen());
+			// meta and system events cancel running status
+			status = 0;
+			if (type == 0x2F)
+				break;
+			continue;
+		}
+
+		if (status == 0xF0 || status == 0xF7)
+		{
+			track.skip(track.varLen());
+			status = 0;
+			continue;
+		}
+
+		if (status > 0xF0)
+			throw std::runtime_error("MidiDecoder error: system message inside a track");
+
+		const uint8_t kind	  = status & 0xF0;
+		const uint8_t channel = status & 0x0F;
+		const uint8_t first	  = track.byte();
+		// program change and channel pressure carry a single data byte
+		const uint8_t second = (kind == 0xC0 || kind == 0xD0) ? 0 : track.byte();
+
+		if (channel == g_percussion)
+			continue;
+
+		if (kind == 0x90 && second > 0)
+			reader.noteOn(slot(tick), noteCode(first), first);
+		else if (kind == 0x80 || kind == 0x90)
+			reader.noteOff(slot(tick), first);
+	}
+
+	reader.finish(slot(tick));
+}
+
+MidiDecoder::CorpusStats MidiDecoder::decodeCorpus(const std::vector<std::string>& paths, Population& genomes, utility::ThreadPool* pool) const
+{
+	// every file decodes into its own population, so the result keeps the order of paths
+	std::vector<Population> decoded(paths.size());
+	std::vector<char> failed(paths.size(), 0);
+
+	auto decodeFiles = [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+		{
+			try
+			{
+				decodeFile(paths[i], decoded[i]);
+			}
+			catch (const std::exception&)
+			{
+				decoded[i].clear();
+				failed[i] = 1;
+			}
+		}
+	};
+
+	if (pool)
+		pool->parallelFor(paths.size(), decodeFiles);
+	else
+		decodeFiles(0, paths.size());
+
+	CorpusStats stats;
+	stats.files	 = paths.size();
+	stats.failed = static_cast<size_t>(std::count(failed.begin(), failed.end(), 1));
+
+	size_t total = genomes.size();
+	for (const auto& population : decoded)
+		total += population.size();
+	genomes.reserve(total);
+
+	for (auto& population : decoded)
+	{
+		stats.genomes += population.size();
+		std::move(population.begin(), population.end(), std::back_inserter(genomes));
+	}
+
+	spdlog::info("Decoded {} genomes from {} MIDI files, {} skipped", stats.genomes, stats.files, stats.failed);
+	return stats;
+}
@@ -1,14 +1,32 @@
 #include "speaker.h"
+#include "synth.h"
 #include <fmt/ostream.h>
+#include <algorithm>
+#include <chrono>
 #include <sstream>
 
-static constexpr int SAMPLING_FREQ = 44100;
-static constexpr int AUDIO_BUFFER_SIZE = 1024;
-static constexpr int MONO			   = 1;
-static constexpr int STEREO			   = 2;
+Speaker::Speaker(const AudioConfig& audioConfig, size_t cacheCapacity) :
+	m_audioConfig(audioConfig),
+	m_queue(audioConfig.queueFrames),
+	m_cacheCapacity(cacheCapacity)
+{
+	if (m_audioConfig.sampleRate <= 0 || m_audioConfig.bufferFrames == 0 || m_audioConfig.channels == 0)
+		throw std::runtime_error("Speaker error: sample rate, buffer size and channels must be positive");
+
+	if (m_queue.capacity() < 2 * size_t{m_audioConfig.bufferFrames})
+		throw std::runtime_error("Speaker error: the output queue must hold at least two device buffers");
+}
 
 Speaker::~Speaker()
 {
+	stopMelody();
+	if (m_audioDevice != 0)
+		SDL_PauseAudioDevice(m_audioDevice, 1);
+
+	Mix_HaltMusic();
+	for (auto& cached : m_cache)
+		Mix_FreeMusic(cached.music);
+
     SDL_CloseAudioDevice(m_audioDevice);
 }
 
@@ -18,24 +36,250 @@ void Speaker::openAudioDevice()
 
 	SDL_AudioSpec audio_spec;
 	SDL_zero(audio_spec);
-	audio_spec.freq		= SAMPLING_FREQ;
-	audio_spec.format	= AUDIO_S16SYS;
-	audio_spec.channels = MONO;
-	audio_spec.samples	= AUDIO_BUFFER_SIZE;
-	audio_spec.callback = NULL;
+	audio_spec.freq		= m_audioConfig.sampleRate;
+	audio_spec.format	= m_audioConfig.format == SampleFormat::F32 ? AUDIO_F32SYS : AUDIO_S16SYS;
+	audio_spec.channels = m_audioConfig.channels;
+	audio_spec.samples	= m_audioConfig.bufferFrames;
+	audio_spec.callback = &Speaker::audioCallback;
+	audio_spec.userdata = this;
+
+	m_callbackBuffer.resize(m_audioConfig.bufferFrames);
 
+	// SDL converts from this format if the hardware wants another one
 	m_audioDevice = SDL_OpenAudioDevice(NULL, 0, &audio_spec, NULL, 0);
-	Mix_OpenAudio(44100, AUDIO_U8, 2, 1024);
+	Mix_OpenAudio(m_audioConfig.sampleRate, AUDIO_U8, 2, 1024);
 	Mix_VolumeMusic(100);
 
     if (m_audioDevice == 0)
         throw std::runtime_error(fmt::format("Speaker error: {}", SDL_GetError()));
+
+    SDL_PauseAudioDevice(m_audioDevice, 0);
+}
+
+size_t Speaker::queueAudio(const int16_t* samples, size_t frames)
+{
+	const size_t written = m_queue.write(samples, frames);
+	m_streaming.store(true, std::memory_order_relaxed);
+	return written;
+}
+
+void Speaker::finishAudio()
+{
+	m_streaming.store(false, std::memory_order_relaxed);
+}
+
+void Speaker::flushAudio()
+{
+	// the callback drops everything written so far the next time it runs
+	m_discardUntil.store(m_queue.writePosition(), std::memory_order_release);
+}
+
+void Speaker::playMelody(Synthesizer& synth, const GeneticAlgorithm::Genome& genome)
+{
+	if (synth.config().sampleRate != m_audioConfig.sampleRate)
+		throw std::runtime_error("Speaker::playMelody error: synthesizer sample rate differs from the device");
+
+	stopMelody();
+
+	synth.load(genome);
+	m_stopRenderer.store(false);
+	m_renderer = std::thread(&Speaker::renderMelody, this, std::ref(synth));
+}
+
+void Speaker::stopMelody()
+{
+	if (!m_renderer.joinable())
+		return;
+
+	m_stopRenderer.store(true);
+	m_renderer.join();
+
+	flushAudio();
+	finishAudio();
+}
+
+void Speaker::renderMelody(Synthesizer& synth)
+{
+	std::array<int16_t, Synthesizer::BLOCK_FRAMES> block;
+
+	// wait for about half a device buffer when the queue is full
+	const auto pause = std::chrono::microseconds(500000LL * m_audioConfig.bufferFrames / m_audioConfig.sampleRate);
+
+	while (!m_stopRenderer.load(std::memory_order_relaxed) && !synth.finished())
+	{
+		if (m_queue.writable() < block.size())
+		{
+			std::this_thread::sleep_for(pause);
+			continue;
+		}
+
+		const size_t frames = synth.render(block.data(), block.size());
+		queueAudio(block.data(), frames);
+	}
+
+	finishAudio();
+}
+
+void SDLCALL Speaker::audioCallback(void* userdata, Uint8* stream, int len)
+{
+	auto* speaker = static_cast<Speaker*>(userdata);
+	const auto& config = speaker->m_audioConfig;
+
+	const size_t sampleSize = config.format == SampleFormat::F32 ? sizeof(float) : sizeof(int16_t);
+	const size_t frameSize	= sampleSize * config.channels;
+	const size_t frames		= static_cast<size_t>(len) / frameSize;
+
+	speaker->m_queue.discardUntil(speaker->m_discardUntil.load(std::memory_order_acquire));
+
+	// mono S16 is read straight into the device buffer
+	if (config.format == SampleFormat::S16 && config.channels == MONO)
+	{
+		auto* samples		= reinterpret_cast<int16_t*>(stream);
+		const size_t played = speaker->m_queue.read(samples, frames);
+		std::fill(samples + played, samples + frames, int16_t{0});
+
+		if (played < frames && speaker->m_streaming.load(std::memory_order_relaxed))
+			speaker->m_underruns.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	bool underrun = false;
+	for (size_t done = 0; done < frames;)
+	{
+		const size_t count	= std::min(frames - done, speaker->m_callbackBuffer.size());
+		int16_t* pcm		= speaker->m_callbackBuffer.data();
+		const size_t played = speaker->m_queue.read(pcm, count);
+		std::fill(pcm + played, pcm + count, int16_t{0});
+		underrun = underrun || played < count;
+
+		Uint8* out = stream + done * frameSize;
+		for (size_t i = 0; i < count; ++i)
+		{
+			for (size_t c = 0; c < config.channels; ++c)
+			{
+				if (config.format == SampleFormat::F32)
+					reinterpret_cast<float*>(out)[i * config.channels + c] = pcm[i] / 32768.0f;
+				else
+					reinterpret_cast<int16_t*>(out)[i * config.channels + c] = pcm[i];
+			}
+		}
+		done += count;
+	}
+
+	if (underrun && speaker->m_streaming.load(std::memory_order_relaxed))
+		speaker->m_underruns.fetch_add(1, std::memory_order_relaxed);
 }
 
 void Speaker::playMidiFile(const std::string& path)
 {
-	Mix_Music* song	= Mix_LoadMUS(path.c_str());
+	play(loadMidiFile(path), true);
+}
+
+void Speaker::playMidiBytes(std::vector<unsigned char> midiBytes)
+{
+	play(loadMidiBytes(std::move(midiBytes)), true);
+}
+
+Mix_Music* Speaker::loadMidiFile(const std::string& path)
+{
+	Mix_Music* music = Mix_LoadMUS(path.c_str());
+	if (music == nullptr)
+		throw std::runtime_error(fmt::format("Speaker error: {}", Mix_GetError()));
+
+	return cache(music, {});
+}
+
+Mix_Music* Speaker::loadMidiBytes(std::vector<unsigned char> midiBytes)
+{
+	SDL_RWops* source = SDL_RWFromConstMem(midiBytes.data(), static_cast<int>(midiBytes.size()));
+	if (source == nullptr)
+		throw std::runtime_error(fmt::format("Speaker error: {}", SDL_GetError()));
+
+	// the mixer closes the RWops together with the music; moving the vector keeps its buffer in place
+	Mix_Music* music = Mix_LoadMUSType_RW(source, MUS_MID, 1);
+	if (music == nullptr)
+		throw std::runtime_error(fmt::format("Speaker error: {}", Mix_GetError()));
+
+	return cache(music, std::move(midiBytes));
+}
+
+Mix_Music* Speaker::cache(Mix_Music* music, std::vector<unsigned char> bytes)
+{
+	std::lock_guard<std::mutex> lock(m_cacheMutex);
+	m_cache.push_back(CachedMusic{music, std::move(bytes), true, ++m_useClock});
+	return music;
+}
+
+void Speaker::evict()
+{
+	size_t unpinned = static_cast<size_t>(std::count_if(m_cache.begin(), m_cache.end(), [](const CachedMusic& cached) { return !cached.pinned; }));
+
+	while (unpinned > m_cacheCapacity)
+	{
+		auto victim = m_cache.end();
+		for (auto it = m_cache.begin(); it != m_cache.end(); ++it)
+		{
+			if (!it->pinned && it->music != m_playing && (victim == m_cache.end() || it->lastUse < victim->lastUse))
+				victim = it;
+		}
+
+		if (victim == m_cache.end())
+			return;
 
-	// Play song
-	Mix_PlayMusic(song, 1);
-}
\ No newline at end of file
+		Mix_FreeMusic(victim->music);
+		m_cache.erase(victim);
+		--unpinned;
+	}
+}
+
+void Speaker::playMusic(Mix_Music* music)
+{
+	play(music, false);
+}
+
+void Speaker::play(Mix_Music* music, bool release)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_cacheMutex);
+		m_playing = music;
+		for (auto& cached : m_cache)
+		{
+			if (cached.music == music)
+			{
+				cached.lastUse = ++m_useClock;
+				cached.pinned  = cached.pinned && !release;
+			}
+		}
+		evict();
+	}
+
+	Mix_PlayMusic(music, 1);
+}
+
+void Speaker::freeMusic(Mix_Music* music)
+{
+	if (music == nullptr)
+		return;
+
+	std::lock_guard<std::mutex> lock(m_cacheMutex);
+	auto it = std::find_if(m_cache.begin(), m_cache.end(), [music](const CachedMusic& cached) { return cached.music == music; });
+	if (it == m_cache.end())
+		return;
+
+	if (m_playing == music)
+		m_playing = nullptr;
+
+	Mix_FreeMusic(music);
+	m_cache.erase(it);
+}
+
+bool Speaker::isPlaying() const
+{
+	return Mix_PlayingMusic() != 0;
+}
+
+size_t Speaker::loadedCount() const
+{
+	std::lock_guard<std::mutex> lock(m_cacheMutex);
+	return m_cache.size();
+}
@@ -0,0 +1,232 @@
+#include "synth.h"
+#include "algorithm/note_events.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+using namespace GeneticAlgorithm;
+
+// relative amplitudes of the harmonics
+static constexpr std::array<float, Synthesizer::PARTIALS> g_partials = {1.0f, 0.5f, 0.25f, 0.125f};
+static constexpr float g_partialsSum = 1.875f;
+
+static constexpr size_t g_wavHeaderSize = 44;
+
+// sin(2 * pi * x) for x in [0, 1): parabola through the zeroes, refined by a second parabola
+static inline float sine(float x)
+{
+	const float t = 0.5f - x; // sin(2 * pi * x) == sin(2 * pi * t) on [-0.5, 0.5]
+	const float y = 8.0f * t - 16.0f * t * std::fabs(t);
+	return 0.225f * (y * std::fabs(y) - y) + y;
+}
+
+static void writeUint32(unsigned char* out, uint32_t value)
+{
+	for (int i = 0; i < 4; ++i)
+		out[i] = static_cast<unsigned char>(value >> (i * 8));
+}
+
+static void writeUint16(unsigned char* out, uint16_t value)
+{
+	out[0] = static_cast<unsigned char>(value);
+	out[1] = static_cast<unsigned char>(value >> 8);
+}
+
+Synthesizer::Synthesizer(const Scale& scale, const SynthConfig& config) : m_config(config)
+{
+	if (m_config.sampleRate <= 0 || m_config.tempo == 0)
+		throw std::runtime_error("Synthesizer error: sample rate and tempo must be positive");
+
+	m_framesPerNote = m_config.sampleRate * 60.0 / m_config.tempo;
+	const auto sampleRate = static_cast<float>(m_config.sampleRate);
+	m_attackSlope		  = 1.0f / std::max(1.0f, m_config.attack * sampleRate);
+	m_releaseSlope		  = -1.0f / std::max(1.0f, m_config.release * sampleRate);
+
+	// the scale holds MIDI note numbers
+	const auto keys = scale.getScale();
+	for (size_t code = 1; code <= keys.size(); ++code)
+	{
+		const double frequency = 440.0 * std::pow(2.0, (keys[code - 1] - 69) / 12.0);
+		m_increments[code]	   = static_cast<float>(frequency / m_config.sampleRate);
+	}
+}
+
+size_t Synthesizer::noteFrame(size_t note) const
+{
+	return static_cast<size_t>(std::llround(static_cast<double>(note) * m_framesPerNote));
+}
+
+size_t Synthesizer::melodyFrames(const Genome& genome) const
+{
+	return noteFrame(genome.noteCount()) + static_cast<size_t>(std::ceil(-1.0f / m_releaseSlope));
+}
+
+void Synthesizer::load(const Genome& genome)
+{
+	const NoteEvents& events = genome.noteEvents();
+
+	m_notes.resize(events.size());
+	for (size_t i = 0; i < events.size(); ++i)
+	{
+		const uint32_t start = events.starts[i];
+		m_notes[i]			 = Note{noteFrame(start), noteFrame(start + events.durations[i]), m_increments[events.degrees[i]]};
+	}
+
+	m_nextNote = 0;
+	m_position = 0;
+	m_end	   = melodyFrames(genome);
+
+	m_active.fill(false);
+	m_gated = MAX_VOICES;
+}
+
+void Synthesizer::startVoice(float increment)
+{
+	// a free voice, or the quietest releasing one
+	size_t voice = 0;
+	for (size_t v = 0; v < MAX_VOICES; ++v)
+	{
+		if (!m_active[v])
+		{
+			voice = v;
+			break;
+		}
+		if (m_envelope[v] < m_envelope[voice])
+			voice = v;
+	}
+
+	m_phase[voice]	   = 0.0f;
+	m_increment[voice] = increment;
+	m_envelope[voice]  = 0.0f;
+	m_slope[voice]	   = m_attackSlope;
+	m_active[voice]	   = true;
+	m_gated			   = voice;
+}
+
+void Synthesizer::releaseVoice()
+{
+	if (m_gated == MAX_VOICES)
+		return;
+
+	m_slope[m_gated] = m_releaseSlope;
+	m_gated			 = MAX_VOICES;
+}
+
+void Synthesizer::renderVoices(float* mix, size_t frames)
+{
+	std::fill(mix, mix + frames, 0.0f);
+
+	const float gain = m_config.gain / g_partialsSum;
+	for (size_t v = 0; v < MAX_VOICES; ++v)
+	{
+		if (!m_active[v])
+			continue;
+
+		const float envelope = m_envelope[v];
+		const float slope	 = m_slope[v];
+
+		for (size_t p = 0; p < PARTIALS; ++p)
+		{
+			const auto harmonic	  = static_cast<float>(p + 1);
+			const float increment = m_increment[v] * harmonic;
+			if (increment >= 0.5f) // above Nyquist
+				break;
+
+			const float start	  = m_phase[v] * harmonic;
+			const float amplitude = gain * g_partials[p];
+			for (size_t i = 0; i < frames; ++i)
+			{
+				float phase = start + increment * static_cast<float>(i);
+				phase -= static_cast<float>(static_cast<int>(phase));
+				const float level = std::min(1.0f, std::max(0.0f, envelope + slope * static_cast<float>(i + 1)));
+				mix[i] += amplitude * level * sine(phase);
+			}
+		}
+
+		const auto blockFrames = static_cast<float>(frames);
+		const float phase	   = m_phase[v] + m_increment[v] * blockFrames;
+		m_phase[v]			   = phase - static_cast<float>(static_cast<int>(phase));
+		m_envelope[v]		   = std::min(1.0f, std::max(0.0f, envelope + slope * blockFrames));
+
+		if (slope < 0.0f && m_envelope[v] == 0.0f)
+			m_active[v] = false;
+	}
+}
+
+size_t Synthesizer::render(int16_t* out, size_t frames)
+{
+	size_t written = 0;
+	while (written < frames && m_position < m_end)
+	{
+		// note boundaries falling on this frame
+		if (m_gated != MAX_VOICES && m_notes[m_nextNote - 1].end <= m_position)
+			releaseVoice();
+		if (m_nextNote < m_notes.size() && m_notes[m_nextNote].start <= m_position)
+			startVoice(m_notes[m_nextNote++].increment);
+
+		// render up to the next boundary
+		size_t until = m_end;
+		if (m_gated != MAX_VOICES)
+			until = std::min(until, m_notes[m_nextNote - 1].end);
+		if (m_nextNote < m_notes.size())
+			until = std::min(until, m_notes[m_nextNote].start);
+
+		const size_t count = std::min({until - m_position, frames - written, BLOCK_FRAMES});
+		renderVoices(m_mix.data(), count);
+
+		for (size_t i = 0; i < count; ++i)
+			out[written + i] = static_cast<int16_t>(std::lrint(std::min(1.0f, std::max(-1.0f, m_mix[i])) * 32767.0f));
+
+		written += count;
+		m_position += count;
+	}
+
+	return written;
+}
+
+void Synthesizer::renderToBuffer(const Genome& genome, std::vector<int16_t>& pcm)
+{
+	load(genome);
+	pcm.resize(m_end);
+	pcm.resize(render(pcm.data(), pcm.size()));
+}
+
+void Synthesizer::renderToWav(const Genome& genome, const std::string& path)
+{
+	std::vector<int16_t> pcm;
+	renderToBuffer(genome, pcm);
+	writeWav(path, pcm.data(), pcm.size(), m_config.sampleRate);
+}
+
+void Synthesizer::writeWav(const std::string& path, const int16_t* pcm, size_t frames, int sampleRate)
+{
+	const uint32_t dataSize = static_cast<uint32_t>(frames * sizeof(int16_t));
+
+	// RIFF header of 16-bit mono PCM, all fields little endian
+	unsigned char header[g_wavHeaderSize] = {'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E', 'f', 'm', 't', ' '};
+	writeUint32(header + 4, static_cast<uint32_t>(g_wavHeaderSize - 8) + dataSize);
+	writeUint32(header + 16, 16);	// fmt chunk size
+	writeUint16(header + 20, 1);	// PCM
+	writeUint16(header + 22, 1);	// channels
+	writeUint32(header + 24, static_cast<uint32_t>(sampleRate));
+	writeUint32(header + 28, static_cast<uint32_t>(sampleRate) * sizeof(int16_t));
+	writeUint16(header + 32, sizeof(int16_t));
+	writeUint16(header + 34, 16);	// bits per sample
+	header[36] = 'd';
+	header[37] = 'a';
+	header[38] = 't';
+	header[39] = 'a';
+	writeUint32(header + 40, dataSize);
+
+	std::vector<unsigned char> bytes(g_wavHeaderSize + dataSize);
+	std::copy(header, header + g_wavHeaderSize, bytes.begin());
+	for (size_t i = 0; i < frames; ++i)
+		writeUint16(bytes.data() + g_wavHeaderSize + i * sizeof(int16_t), static_cast<uint16_t>(pcm[i]));
+
+	std::ofstream wavFile(path, std::ios::binary);
+	wavFile.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+	if (!wavFile)
+		throw std::runtime_error("Synthesizer error: cannot write " + path);
+}
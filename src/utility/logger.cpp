@@ -1,4 +1,5 @@
 #include "utility/logger.h"
+#include <spdlog/async.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
 
@@ -11,24 +12,34 @@
 #include <X11/Xlib.h>
 #endif
 
-std::shared_ptr<spdlog::logger> utility::setupLogger(const std::vector<spdlog::sink_ptr>& sinks)
+std::shared_ptr<spdlog::logger> utility::setupLogger(const std::vector<spdlog::sink_ptr>& sinks, const LoggerConfig& config)
 {
 	constexpr auto logger_name = "core";
 	auto logger = spdlog::get(logger_name);
 	if (!logger)
 	{
-		if (sinks.size() > 0)
+		std::vector<spdlog::sink_ptr> loggerSinks = sinks;
+		if (loggerSinks.empty())
 		{
-			logger = std::make_shared<spdlog::logger>(logger_name, std::begin(sinks), std::end(sinks));
+			loggerSinks.push_back(std::make_shared<spdlog::sinks::stdout_color_sink_mt>());
+		}
+
+		if (config.mode == LogMode::ASYNC)
+		{
+			// the queue and its threads are shared by all async loggers
+			spdlog::init_thread_pool(config.queueSize, config.threads);
+			const auto policy = config.overflow == LogOverflow::BLOCK ? spdlog::async_overflow_policy::block : spdlog::async_overflow_policy::overrun_oldest;
+			logger = std::make_shared<spdlog::async_logger>(logger_name, std::begin(loggerSinks), std::end(loggerSinks), spdlog::thread_pool(), policy);
 		}
 		else
 		{
-			logger = spdlog::stdout_color_mt(logger_name);
+			logger = std::make_shared<spdlog::logger>(logger_name, std::begin(loggerSinks), std::end(loggerSinks));
 		}
 		spdlog::register_logger(logger);
 		spdlog::set_default_logger(logger);
 		spdlog::set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%t] [%n] [%l] %v", spdlog::pattern_time_type::utc);
-		spdlog::flush_every(std::chrono::seconds(5));
+		logger->flush_on(spdlog::level::warn);
+		spdlog::flush_every(config.flushInterval);
 	}
 	return logger;
 }
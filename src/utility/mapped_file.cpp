@@ -0,0 +1,118 @@
+#include "utility/mapped_file.h"
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace utility;
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path, FileAccess access)
+{
+	const DWORD flags = access == FileAccess::RANDOM ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN;
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		throw std::runtime_error("MappedFile error: cannot open " + path);
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		CloseHandle(file);
+		throw std::runtime_error("MappedFile error: cannot read the size of " + path);
+	}
+
+	m_size = static_cast<size_t>(size.QuadPart);
+	if (m_size == 0)
+	{
+		CloseHandle(file);
+		return;
+	}
+
+	// the view keeps the file open, both handles can go
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (mapping == nullptr)
+		throw std::runtime_error("MappedFile error: cannot map " + path);
+
+	m_data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	CloseHandle(mapping);
+	if (m_data == nullptr)
+		throw std::runtime_error("MappedFile error: cannot map " + path);
+}
+
+void MappedFile::close()
+{
+	if (m_data != nullptr)
+		UnmapViewOfFile(m_data);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path, FileAccess access)
+{
+	const int file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		throw std::runtime_error("MappedFile error: cannot open " + path);
+
+	struct stat status;
+	if (::fstat(file, &status) != 0)
+	{
+		::close(file);
+		throw std::runtime_error("MappedFile error: cannot read the size of " + path);
+	}
+
+	m_size = static_cast<size_t>(status.st_size);
+	if (m_size == 0)
+	{
+		::close(file);
+		return;
+	}
+
+	// the mapping keeps the file open, the descriptor can go
+	void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+	::close(file);
+	if (data == MAP_FAILED)
+		throw std::runtime_error("MappedFile error: cannot map " + path);
+
+	::madvise(data, m_size, access == FileAccess::RANDOM ? MADV_RANDOM : MADV_SEQUENTIAL);
+	m_data = static_cast<const unsigned char*>(data);
+}
+
+void MappedFile::close()
+{
+	if (m_data != nullptr)
+		::munmap(const_cast<unsigned char*>(m_data), m_size);
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept :
+	m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0))
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+		m_data = std::exchange(other.m_data, nullptr);
+		m_size = std::exchange(other.m_size, 0);
+	}
+	return *this;
+}
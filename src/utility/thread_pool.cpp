@@ -0,0 +1,173 @@
+#include "utility/thread_pool.h"
+#include <algorithm>
+
+using namespace utility;
+
+ThreadPool::ThreadPool(size_t threads)
+{
+	if (threads == 0)
+		threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+	// last queue is shared by threads outside the pool
+	for (size_t i = 0; i <= threads; ++i)
+		m_queues.push_back(std::make_unique<Queue>());
+
+	m_workers.reserve(threads);
+	for (size_t i = 0; i < threads; ++i)
+		m_workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+
+	for (auto& worker : m_workers)
+		worker.join();
+}
+
+void ThreadPool::Queue::pushBack(const Task& task)
+{
+	if (count == ring.size())
+	{
+		// grow and unwrap so that head is at 0 again
+		std::vector<Task> grown;
+		grown.reserve(std::max<size_t>(16, ring.size() * 2));
+		for (size_t i = 0; i < count; ++i)
+			grown.push_back(ring[(head + i) % ring.size()]);
+		grown.resize(grown.capacity(), task);
+		ring = std::move(grown);
+		head = 0;
+	}
+	ring[(head + count) % ring.size()] = task;
+	++count;
+}
+
+bool ThreadPool::Queue::popBack(Task& task)
+{
+	if (count == 0)
+		return false;
+	--count;
+	task = ring[(head + count) % ring.size()];
+	return true;
+}
+
+bool ThreadPool::Queue::popFront(Task& task)
+{
+	if (count == 0)
+		return false;
+	task = ring[head];
+	head = (head + 1) % ring.size();
+	--count;
+	return true;
+}
+
+void ThreadPool::run(size_t count, RangeRef body, size_t grain)
+{
+	if (count == 0)
+		return;
+
+	if (grain == 0)
+		grain = std::max<size_t>(1, count / (m_workers.size() * 8));
+
+	Batch batch;
+	const size_t chunks = (count + grain - 1) / grain;
+	batch.remaining.store(chunks);
+
+	// counted before they are queued, so a worker that takes a task never drives m_pending below zero
+	m_pending.fetch_add(chunks);
+
+	const size_t workers = m_workers.size();
+	size_t target		 = m_nextQueue.fetch_add(1) % workers;
+	for (size_t begin = 0; begin < count; begin += grain)
+	{
+		auto& queue = *m_queues[target];
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.pushBack(Task{body, begin, std::min(count, begin + grain), &batch});
+		}
+		target = (target + 1) % workers;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+	}
+	m_wake.notify_all();
+
+	// help with the work until nothing is left to take, then wait for chunks still running
+	while (batch.remaining.load() > 0 && tryRunTask(m_queues.size() - 1))
+	{
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(batch.mutex);
+		batch.done.wait(lock, [&] { return batch.remaining.load() == 0; });
+	}
+
+	if (batch.error)
+		std::rethrow_exception(batch.error);
+}
+
+bool ThreadPool::tryRunTask(size_t self)
+{
+	Task task{};
+	bool found = false;
+
+	{
+		auto& own = *m_queues[self];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		found = own.popBack(task);
+	}
+
+	for (size_t i = 1; !found && i < m_queues.size(); ++i)
+	{
+		auto& victim = *m_queues[(self + i) % m_queues.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		found = victim.popFront(task);
+	}
+
+	if (!found)
+		return false;
+
+	m_pending.fetch_sub(1);
+	runTask(task);
+	return true;
+}
+
+void ThreadPool::runTask(const Task& task)
+{
+	Batch& batch = *task.batch;
+
+	try
+	{
+		task.body(task.begin, task.end);
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lock(batch.mutex);
+		if (!batch.error)
+			batch.error = std::current_exception();
+	}
+
+	// decrement under the lock: the caller owns the batch and may destroy it as soon as it sees zero
+	std::lock_guard<std::mutex> lock(batch.mutex);
+	if (batch.remaining.fetch_sub(1) == 1)
+		batch.done.notify_all();
+}
+
+void ThreadPool::workerLoop(size_t idx)
+{
+	for (;;)
+	{
+		if (tryRunTask(idx))
+			continue;
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_wake.wait(lock, [&] { return m_stop || m_pending.load() > 0; });
+		if (m_stop && m_pending.load() == 0)
+			return;
+	}
+}